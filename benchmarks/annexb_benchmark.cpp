@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+#include "benchmark_util.h"
+#include "common/annexb.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr size_t kSyntheticSize = 64 << 20;
+constexpr double kMinSeconds = 0.5;
+
+// Walks every start code of |data| the way the packetizer splits a frame,
+// returns how many were found.
+size_t count_start_codes(std::span<const uint8_t> data, StartCode (*find)(std::span<const uint8_t>))
+{
+    size_t count = 0;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        auto start_code = find(data.subspan(offset));
+        if (start_code.length == 0) {
+            break;
+        }
+        count++;
+        offset += start_code.offset + start_code.length;
+    }
+    return count;
+}
+
+void bench(const char* name, std::span<const uint8_t> data)
+{
+    for (auto [variant, find] : { std::pair { "dispatch", &find_start_code }, std::pair { "scalar", &find_start_code_scalar } }) {
+        size_t rounds = 0;
+        size_t start_codes = 0;
+        Stopwatch stopwatch;
+        do {
+            start_codes = count_start_codes(data, find);
+            rounds++;
+        } while (stopwatch.elapsed_s() < kMinSeconds);
+        const double ns = stopwatch.elapsed_ns();
+        keep(start_codes);
+        printf("%-20s %-8s %9zu bytes  %7zu start codes  %.2f GB/s\n", name, variant, data.size(), start_codes, data.size() * rounds / ns);
+    }
+}
+
+// Random bytes without any 00 00 pair, the scanner never stops early.
+std::vector<uint8_t> make_no_start_codes()
+{
+    std::mt19937 rng { 1 };
+    std::vector<uint8_t> data(kSyntheticSize);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng() | 0x80);
+    }
+    return data;
+}
+
+// NAL units of |nalu_size| bytes behind 4-byte start codes, slice-like data
+// with the zero bytes emulation prevention leaves in.
+std::vector<uint8_t> make_nalus(size_t nalu_size)
+{
+    std::mt19937 rng { 2 };
+    std::vector<uint8_t> data;
+    data.reserve(kSyntheticSize);
+    while (data.size() + nalu_size + 4 <= kSyntheticSize) {
+        data.insert(data.end(), { 0, 0, 0, 1 });
+        for (size_t i = 0; i < nalu_size; i++) {
+            const uint8_t byte = static_cast<uint8_t>(rng());
+            // 00 00 is always followed by 03 or more in a real NAL unit.
+            const bool after_zeros = data.size() >= 2 && data[data.size() - 1] == 0 && data[data.size() - 2] == 0;
+            data.push_back(after_zeros && byte < 3 ? 3 : byte);
+        }
+    }
+    return data;
+}
+
+std::vector<uint8_t> read_file(const char* path)
+{
+    std::ifstream file { path, std::ios::binary };
+    return std::vector<uint8_t> { std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {} };
+}
+
+} // namespace
+
+// Pass raw H.264 Annex-B files to measure real bitstreams as well.
+int main(int argc, char* argv[])
+{
+    bench("no start codes", make_no_start_codes());
+    bench("1200 byte nalus", make_nalus(1200));
+    bench("16 KB nalus", make_nalus(16 << 10));
+    for (int i = 1; i < argc; i++) {
+        auto data = read_file(argv[i]);
+        if (data.empty()) {
+            printf("can not read %s\n", argv[i]);
+            continue;
+        }
+        bench(argv[i], data);
+    }
+    return 0;
+}
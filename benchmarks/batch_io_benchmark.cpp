@@ -0,0 +1,119 @@
+#include <cstdio>
+#include <array>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <bco/net/address.h>
+#include "benchmark_util.h"
+#include "transport/batch_io.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr size_t kPacketSize = 1200;
+constexpr int kRounds = 20000;
+constexpr size_t kBatchSize = BatchIo::kMaxBatchSize;
+
+int open_loopback_socket(uint16_t& port)
+{
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+struct Result {
+    uint64_t packets = 0;
+    uint64_t syscalls = 0;
+    double seconds = 0;
+};
+
+void print(const char* name, const Result& result)
+{
+    printf("%-10s %.0f packets/s  %.2f syscalls/packet\n",
+        name, result.packets / result.seconds, static_cast<double>(result.syscalls) / result.packets);
+}
+
+// Every round sends a burst of |kBatchSize| datagrams and reads them back,
+// which is what a relay sees on a busy socket.
+Result bench_single(int sender, int receiver, uint16_t port)
+{
+    sockaddr_in to {};
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    to.sin_port = htons(port);
+    std::array<uint8_t, kPacketSize> packet {};
+    std::array<uint8_t, 2048> buffer {};
+    Result result;
+    Stopwatch stopwatch;
+    for (int round = 0; round < kRounds; round++) {
+        for (size_t i = 0; i < kBatchSize; i++) {
+            ::sendto(sender, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr*>(&to), sizeof(to));
+            result.syscalls++;
+        }
+        for (;;) {
+            auto ret = ::recvfrom(receiver, buffer.data(), buffer.size(), MSG_DONTWAIT, nullptr, nullptr);
+            result.syscalls++;
+            if (ret < 0) {
+                break;
+            }
+            result.packets++;
+        }
+    }
+    result.seconds = stopwatch.elapsed_s();
+    return result;
+}
+
+Result bench_batch(int sender, int receiver, uint16_t port)
+{
+    BatchIo send_io { sender };
+    BatchIo recv_io { receiver };
+    bco::net::Address to { bco::net::IPv4 { "127.0.0.1" }, port };
+    std::vector<bco::Buffer> packets;
+    std::vector<bco::Buffer> buffers;
+    for (size_t i = 0; i < kBatchSize; i++) {
+        packets.emplace_back(kPacketSize);
+        buffers.emplace_back(2048);
+    }
+    std::array<int, kBatchSize> sizes {};
+    Result result;
+    Stopwatch stopwatch;
+    for (int round = 0; round < kRounds; round++) {
+        send_io.send(packets, to, result.syscalls);
+        for (;;) {
+            int count = recv_io.recv(buffers, sizes);
+            result.syscalls++;
+            if (count == 0) {
+                break;
+            }
+            result.packets += count;
+        }
+    }
+    result.seconds = stopwatch.elapsed_s();
+    return result;
+}
+
+} // namespace
+
+int main()
+{
+    uint16_t port = 0;
+    uint16_t unused_port = 0;
+    int receiver = open_loopback_socket(port);
+    int sender = open_loopback_socket(unused_port);
+    printf("loopback, %zu byte datagrams in bursts of %zu\n", kPacketSize, kBatchSize);
+    print("sendto", bench_single(sender, receiver, port));
+    print("sendmmsg", bench_batch(sender, receiver, port));
+    ::close(sender);
+    ::close(receiver);
+    return 0;
+}
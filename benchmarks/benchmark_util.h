@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace brtc::benchmark {
+
+class Stopwatch {
+public:
+    Stopwatch()
+        : start_(std::chrono::steady_clock::now())
+    {
+    }
+    void restart() { start_ = std::chrono::steady_clock::now(); }
+    double elapsed_ns() const
+    {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_).count();
+    }
+    double elapsed_s() const { return elapsed_ns() / 1e9; }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+inline volatile uint64_t g_sink = 0;
+
+// Stores |value| where the compiler must assume it is read, so the work that
+// produced it is not optimized away.
+template <typename T>
+inline void keep(T value)
+{
+    g_sink = g_sink + static_cast<uint64_t>(value);
+}
+
+// User plus system time of the whole process, in seconds.
+inline double process_cpu_seconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    ::GetProcessTimes(::GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    auto to_100ns = [](const FILETIME& time) {
+        return static_cast<uint64_t>(time.dwHighDateTime) << 32 | time.dwLowDateTime;
+    };
+    return (to_100ns(kernel) + to_100ns(user)) / 1e7;
+#else
+    rusage usage {};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+inline void init_sockets()
+{
+#ifdef _WIN32
+    WSADATA wsdata;
+    (void)::WSAStartup(MAKEWORD(2, 2), &wsdata);
+#endif
+}
+
+} // namespace brtc::benchmark
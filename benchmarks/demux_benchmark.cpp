@@ -0,0 +1,84 @@
+#include <cstdio>
+#include <array>
+#include <random>
+#include <utility>
+#include <vector>
+#include "benchmark_util.h"
+#include "transport/demux.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr size_t kDatagrams = 4096;
+constexpr int kRounds = 2000;
+
+bco::Buffer make_datagram(std::initializer_list<uint8_t> head, size_t size)
+{
+    bco::Buffer datagram(size);
+    size_t i = 0;
+    for (uint8_t byte : head) {
+        datagram[i++] = byte;
+    }
+    return datagram;
+}
+
+bco::Buffer make_rtp() { return make_datagram({ 0x80, 96 }, 1200); }
+bco::Buffer make_rtcp() { return make_datagram({ 0x81, 200 }, 28); }
+bco::Buffer make_stun() { return make_datagram({ 0x00, 0x01 }, 20); }
+bco::Buffer make_dtls() { return make_datagram({ 22, 0xfe, 0xfd }, 100); }
+bco::Buffer make_quic() { return make_datagram({ 0xc3 }, 1200); }
+
+// |kDatagrams| datagrams, each drawn from |makers| with the given weights.
+std::vector<bco::Buffer> make_mix(const std::vector<std::pair<bco::Buffer (*)(), int>>& makers)
+{
+    std::mt19937 rng { 1 };
+    int total_weight = 0;
+    for (const auto& maker : makers) {
+        total_weight += maker.second;
+    }
+    std::vector<bco::Buffer> datagrams;
+    for (size_t i = 0; i < kDatagrams; i++) {
+        int pick = static_cast<int>(rng() % total_weight);
+        for (const auto& [make, weight] : makers) {
+            if (pick < weight) {
+                datagrams.push_back(make());
+                break;
+            }
+            pick -= weight;
+        }
+    }
+    return datagrams;
+}
+
+void bench(const char* name, const std::vector<bco::Buffer>& datagrams)
+{
+    std::array<uint64_t, kDatagramTypeCount> counts {};
+    Stopwatch stopwatch;
+    for (int round = 0; round < kRounds; round++) {
+        for (const auto& datagram : datagrams) {
+            counts[static_cast<size_t>(classify_datagram(datagram))]++;
+        }
+    }
+    const double ns = stopwatch.elapsed_ns();
+    const double total = static_cast<double>(kRounds) * datagrams.size();
+    printf("%-10s %.2f ns/datagram  rtp %.1f%%  rtcp %.1f%%  stun %.1f%%  dtls %.1f%%  quic %.1f%%  unknown %.1f%%\n", name, ns / total,
+        counts[static_cast<size_t>(DatagramType::Rtp)] * 100 / total,
+        counts[static_cast<size_t>(DatagramType::Rtcp)] * 100 / total,
+        counts[static_cast<size_t>(DatagramType::Stun)] * 100 / total,
+        counts[static_cast<size_t>(DatagramType::Dtls)] * 100 / total,
+        counts[static_cast<size_t>(DatagramType::Quic)] * 100 / total,
+        counts[static_cast<size_t>(DatagramType::Unknown)] * 100 / total);
+}
+
+} // namespace
+
+int main()
+{
+    printf("classify_datagram() over %zu datagrams\n", kDatagrams);
+    bench("rtp only", make_mix({ { make_rtp, 1 } }));
+    bench("media", make_mix({ { make_rtp, 90 }, { make_rtcp, 9 }, { make_stun, 1 } }));
+    bench("all types", make_mix({ { make_rtp, 1 }, { make_rtcp, 1 }, { make_stun, 1 }, { make_dtls, 1 }, { make_quic, 1 } }));
+    return 0;
+}
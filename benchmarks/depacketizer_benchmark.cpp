@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <vector>
+#include "benchmark_util.h"
+#include "common/buffer_pool.h"
+#include "video/depacketizer/depacketizer.h"
+#include "video/packetizer/packetizer.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr double kMinSeconds = 0.5;
+constexpr size_t kMaxPayloadSize = 1192;
+
+void append_nalu(std::vector<uint8_t>& frame, uint8_t header, size_t size)
+{
+    frame.insert(frame.end(), { 0, 0, 0, 1, header });
+    for (size_t i = 1; i < size; i++) {
+        frame.push_back(static_cast<uint8_t>(i * 7 + 3) | 1);
+    }
+}
+
+// An IDR frame of |slices| slices of |slice_size| bytes behind SPS and PPS.
+std::vector<uint8_t> make_frame(size_t slices, size_t slice_size)
+{
+    std::vector<uint8_t> frame;
+    append_nalu(frame, 0x67, 20);
+    append_nalu(frame, 0x68, 4);
+    for (size_t i = 0; i < slices; i++) {
+        append_nalu(frame, 0x65, slice_size);
+    }
+    return frame;
+}
+
+// The packets of |encoded| as they come off the wire, each in one buffer.
+std::vector<bco::Buffer> packetize(const std::vector<uint8_t>& encoded)
+{
+    BufferPool pool { 1500, 64 };
+    Frame frame;
+    frame.type = Frame::UnderlyingType::kMemory;
+    frame.data = const_cast<uint8_t*>(encoded.data());
+    frame.length = static_cast<uint32_t>(encoded.size());
+    Packetizer::PayloadSizeLimits limits;
+    limits.max_payload_len = static_cast<int>(kMaxPayloadSize);
+    auto packetizer = Packetizer::create(frame, VideoCodecType::H264, limits);
+    std::vector<bco::Buffer> datagrams;
+    uint16_t seq_num = 0;
+    while (packetizer->has_next_packet()) {
+        RtpPacket packet = RtpPacket::create(pool);
+        packet.set_ssrc(1);
+        packet.set_sequence_number(seq_num++);
+        packet.set_timestamp(3000);
+        packetizer->next_packet(packet);
+        std::vector<uint8_t> bytes;
+        for (auto span : packet.data().data()) {
+            bytes.insert(bytes.end(), span.begin(), span.end());
+        }
+        bco::Buffer datagram(bytes.size());
+        for (size_t i = 0; i < bytes.size(); i++) {
+            datagram[i] = bytes[i];
+        }
+        datagrams.push_back(datagram);
+    }
+    return datagrams;
+}
+
+void bench(const char* name, const std::vector<uint8_t>& encoded)
+{
+    const auto datagrams = packetize(encoded);
+    auto depacketizer = Depacketizer::create(VideoCodecType::H264);
+    std::vector<std::span<const uint8_t>> slices;
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    Stopwatch stopwatch;
+    do {
+        slices.clear();
+        for (const auto& datagram : datagrams) {
+            RtpPacket packet { datagram };
+            depacketizer->parse(packet);
+            depacketizer->append_bitstream(packet, slices);
+            bytes += packet.payload_size();
+        }
+        packets += datagrams.size();
+        keep(slices.size());
+    } while (stopwatch.elapsed_s() < kMinSeconds);
+    const double ns = stopwatch.elapsed_ns();
+    printf("%-14s %4zu packets/frame  %.0f ns/packet  %.2f GB/s\n", name, datagrams.size(), ns / packets, bytes / ns);
+}
+
+} // namespace
+
+int main()
+{
+    printf("RTP header parse, H.264 depacketization and bitstream slices\n");
+    // Small slices are aggregated into STAP-A, mid sized ones go one per
+    // packet and large ones are fragmented into FU-A.
+    bench("STAP-A", make_frame(64, 100));
+    bench("single NALU", make_frame(64, 1000));
+    bench("FU-A", make_frame(1, 200 * 1024));
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <bco/context.h>
+#include <bco/coroutine/channel.h>
+#include <brtc/executor.h>
+#include "benchmark_util.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+// Split over the sessions of a round, so every round does the same work.
+constexpr uint64_t kRoundTrips = 256000;
+
+// Two coroutines of one context handing a timestamp back and forth, the way
+// a decode and a render loop wake each other up.
+struct Session {
+    std::shared_ptr<bco::Context> context;
+    bco::Channel<int64_t> ping;
+    bco::Channel<int64_t> pong;
+    // Only touched on |context|.
+    std::vector<int64_t> latencies;
+};
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bco::Routine pinger(Session* session, uint64_t round_trips, std::atomic<size_t>* finished)
+{
+    for (uint64_t i = 0; i < round_trips; i++) {
+        session->ping.send(now_ns());
+        const int64_t sent_ns = co_await session->pong.recv();
+        session->latencies.push_back(now_ns() - sent_ns);
+    }
+    finished->fetch_add(1);
+}
+
+bco::Routine ponger(Session* session)
+{
+    while (true) {
+        const int64_t sent_ns = co_await session->ping.recv();
+        session->latencies.push_back(now_ns() - sent_ns);
+        session->pong.send(now_ns());
+    }
+}
+
+// The contexts of a round never stop, sessions are only released when the
+// process exits.
+void bench(const char* name, size_t sessions, const std::function<std::unique_ptr<bco::ExecutorInterface>()>& create_executor)
+{
+    const uint64_t round_trips = kRoundTrips / sessions;
+    auto finished = new std::atomic<size_t> { 0 };
+    std::vector<Session*> round;
+    for (size_t i = 0; i < sessions; i++) {
+        auto session = new Session;
+        session->latencies.reserve(round_trips * 2);
+        session->context = std::make_shared<bco::Context>(create_executor());
+        session->context->spawn(std::bind(ponger, session));
+        session->context->spawn(std::bind(pinger, session, round_trips, finished));
+        round.push_back(session);
+    }
+    Stopwatch stopwatch;
+    for (auto session : round) {
+        session->context->start();
+    }
+    while (*finished < sessions) {
+        std::this_thread::yield();
+    }
+    const double wall_seconds = stopwatch.elapsed_s();
+
+    std::vector<int64_t> latencies;
+    for (auto session : round) {
+        latencies.insert(latencies.end(), session->latencies.begin(), session->latencies.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return static_cast<long long>(latencies[static_cast<size_t>(p * (latencies.size() - 1))]); };
+    printf("%-16s sessions=%4zu  %.2f M resumes/s  p50 %lld ns  p99 %lld ns  max %lld ns\n", name, sessions,
+        latencies.size() / wall_seconds / 1e6, percentile(0.5), percentile(0.99), percentile(1.0));
+}
+
+} // namespace
+
+int main()
+{
+    // Kept alive with the contexts running on it.
+    auto pool = new WorkStealingPool;
+    printf("coroutine resume through bco::Channel, %zu pool workers\n", pool->worker_count());
+    for (size_t sessions : { 1, 16, 256 }) {
+        bench("SimpleExecutor", sessions, []() { return std::make_unique<bco::SimpleExecutor>(); });
+        bench("WorkStealingPool", sessions, [pool]() { return pool->create_executor(); });
+    }
+    return 0;
+}
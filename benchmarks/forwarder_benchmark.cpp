@@ -0,0 +1,111 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <bco/context.h>
+#include <brtc/interface.h>
+#include "benchmark_util.h"
+#include "loopback_util.h"
+#include "transport/transport.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr uint16_t kBasePort = 47000;
+constexpr size_t kDefaultSubscribers = 100;
+constexpr uint64_t kSourcePackets = 20000;
+// Small packets, the sink socket buffer has to hold a whole fan-out.
+constexpr size_t kPacketSize = 200;
+constexpr uint32_t kSourceSsrc = 0x1000;
+constexpr uint32_t kFirstSubscriberSsrc = 0x2000;
+constexpr auto kDrainTimeout = std::chrono::milliseconds { 1000 };
+
+std::shared_ptr<bco::Context> make_context(std::unique_ptr<Proactor> proactor)
+{
+    auto context = std::make_shared<bco::Context>(std::make_unique<bco::SimpleExecutor>());
+    context->add_proactor(std::move(proactor));
+    return context;
+}
+
+std::unique_ptr<Proactor> make_proactor()
+{
+    auto proactor = std::make_unique<Proactor>();
+    proactor->start(std::make_unique<bco::SimpleExecutor>());
+    return proactor;
+}
+
+// Single NALU packets, an IDR first so subscribers take the source right away.
+bco::Buffer make_source_packet(uint16_t seq_num, bool keyframe)
+{
+    bco::Buffer packet(kPacketSize);
+    packet[0] = 0x80;
+    packet[1] = 96;
+    packet.write_big_endian_at(2, seq_num);
+    packet.write_big_endian_at(4, static_cast<uint32_t>(seq_num) * 3000);
+    packet.write_big_endian_at(8, kSourceSsrc);
+    packet[12] = keyframe ? 0x65 : 0x41;
+    return packet;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    init_sockets();
+    const size_t subscribers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : kDefaultSubscribers;
+    uint16_t next_port = kBasePort;
+
+    // The forwarder gets a context of its own, everything else runs on a
+    // second one. Nothing is torn down, the process exits after one run.
+    auto forwarder_proactor = make_proactor();
+    auto sink_proactor = make_proactor();
+    const auto sender_addr = loopback_address(next_port);
+    UdpSocket sender = open_socket(sink_proactor.get(), next_port++);
+    const auto sink_addr = loopback_address(next_port);
+    TransportInfo sink_info { .socket = open_socket(sink_proactor.get(), next_port++) };
+    const auto ingress_addr = loopback_address(next_port);
+    TransportInfo ingress_info { .socket = open_socket(forwarder_proactor.get(), next_port++), .remote_addr = sender_addr };
+    std::vector<TransportInfo> subscriber_infos;
+    for (size_t i = 0; i < subscribers; i++) {
+        subscriber_infos.push_back(TransportInfo { .socket = open_socket(forwarder_proactor.get(), next_port++), .remote_addr = sink_addr });
+    }
+
+    auto forwarder_ctx = make_context(std::move(forwarder_proactor));
+    auto forwarder = new MediaForwarder { ingress_info, forwarder_ctx };
+    for (size_t i = 0; i < subscribers; i++) {
+        const uint32_t ssrc = kFirstSubscriberSsrc + static_cast<uint32_t>(i);
+        forwarder->add_subscriber(subscriber_infos[i], ssrc);
+        forwarder->select_source(ssrc, kSourceSsrc);
+    }
+    forwarder->start();
+
+    auto sink_ctx = make_context(std::move(sink_proactor));
+    auto sink = new Transport { sink_ctx, sink_info };
+    auto received = new std::atomic<uint64_t> { 0 };
+    sink_ctx->spawn(std::bind(count_rtp_loop, sink, received));
+    forwarder_ctx->start();
+    sink_ctx->start();
+
+    // The next fan-out only starts once half of the last one arrived, the sink
+    // socket buffer would overflow otherwise.
+    InFlightLimiter limiter { *received, std::max<size_t>(subscribers / 2, 1), kDrainTimeout };
+    const double cpu_start = process_cpu_seconds();
+    Stopwatch stopwatch;
+    for (uint64_t sent = 0; sent < kSourcePackets; sent++) {
+        limiter.wait(sent * subscribers);
+        sender.sendto(make_source_packet(static_cast<uint16_t>(sent), sent == 0), ingress_addr);
+    }
+    const uint64_t forwarded = wait_for_packets(*received, kSourcePackets * subscribers, kDrainTimeout);
+    const double cpu_seconds = process_cpu_seconds() - cpu_start;
+    const double wall_seconds = stopwatch.elapsed_s();
+    printf("1 -> %zu fan-out, %zu byte packets, cpu includes the sender and the sink\n", subscribers, kPacketSize);
+    printf("source packets=%llu  forwarded=%llu  %.0f packets/s  %.0f packets/s per core\n",
+        static_cast<unsigned long long>(kSourcePackets), static_cast<unsigned long long>(forwarded),
+        forwarded / wall_seconds, forwarded / cpu_seconds);
+    return 0;
+}
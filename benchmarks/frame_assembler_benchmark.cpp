@@ -0,0 +1,173 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "benchmark_util.h"
+#include "video/frame_assembler/frame_assembler.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr size_t kRtpHeaderSize = 12;
+constexpr size_t kPayloadSize = 1200;
+constexpr uint32_t kTimestampStep = 3000;
+// Insert cost does not depend on the payload, keep the streams that only
+// measure insert() small.
+constexpr size_t kSmallPayloadSize = 100;
+
+RtpPacket make_packet(uint16_t seq_num, uint32_t timestamp, bool last, bool keyframe, size_t payload_size = kPayloadSize)
+{
+    bco::Buffer buffer(kRtpHeaderSize + payload_size);
+    buffer[0] = 0x80;
+    buffer[1] = last ? 0x80 | 96 : 96;
+    buffer.write_big_endian_at(2, seq_num);
+    buffer.write_big_endian_at(4, timestamp);
+    buffer.write_big_endian_at(8, 1u);
+    RtpPacket packet { buffer };
+    RTPVideoHeaderH264 header {};
+    header.codec = VideoCodecType::H264;
+    header.is_last_packet_in_frame = last;
+    NaluInfo nalu {};
+    nalu.type = keyframe ? H264NaluType::Idr : H264NaluType::Slice;
+    header.nalus.push_back(nalu);
+    packet.set_video_header(header);
+    return packet;
+}
+
+// |frames| frames of |packets_per_frame| packets each, the first one a keyframe.
+std::vector<RtpPacket> make_stream(int frames, int packets_per_frame, size_t payload_size = kPayloadSize)
+{
+    std::vector<RtpPacket> packets;
+    packets.reserve(frames * packets_per_frame);
+    uint16_t seq_num = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        for (int i = 0; i < packets_per_frame; i++) {
+            packets.push_back(make_packet(seq_num++, frame * kTimestampStep, i == packets_per_frame - 1, frame == 0, payload_size));
+        }
+    }
+    return packets;
+}
+
+// Packets of 4-packet frames with a keyframe every 60 frames. Packets of delta
+// frames are lost at random or in bursts of 16, keyframes always arrive so
+// the assembler recovers.
+std::vector<RtpPacket> make_lossy_stream(int loss_percent, bool burst)
+{
+    constexpr int kFrames = 50000;
+    constexpr int kPacketsPerFrame = 4;
+    constexpr int kKeyframeInterval = 60;
+    constexpr int kBurstLength = 16;
+    std::mt19937 rng { 1 };
+    std::vector<RtpPacket> packets;
+    uint16_t seq_num = 0;
+    int burst_left = 0;
+    for (int frame = 0; frame < kFrames; frame++) {
+        const bool keyframe = frame % kKeyframeInterval == 0;
+        for (int i = 0; i < kPacketsPerFrame; i++, seq_num++) {
+            bool lost = false;
+            if (burst) {
+                if (burst_left == 0 && static_cast<int>(rng() % (100 * kBurstLength)) < loss_percent) {
+                    burst_left = kBurstLength;
+                }
+                lost = burst_left > 0;
+                burst_left = lost ? burst_left - 1 : 0;
+            } else {
+                lost = static_cast<int>(rng() % 100) < loss_percent;
+            }
+            if (lost && !keyframe) {
+                continue;
+            }
+            packets.push_back(make_packet(seq_num, frame * kTimestampStep, i == kPacketsPerFrame - 1, keyframe, kSmallPayloadSize));
+        }
+    }
+    return packets;
+}
+
+// Bytes copied out of the packets to build |frame|, slices point into the
+// packets themselves.
+size_t copied_bytes(const Frame& frame)
+{
+    return frame.type == Frame::UnderlyingType::kMemory ? frame.length : 0;
+}
+
+void bench_pop(const char* name, bool contiguous)
+{
+    constexpr int kFrames = 20000;
+    constexpr int kPacketsPerFrame = 8;
+    auto packets = make_stream(kFrames, kPacketsPerFrame);
+    FrameAssembler assembler { 512, 2048 };
+    size_t frames = 0;
+    size_t copied = 0;
+    Stopwatch stopwatch;
+    for (auto& packet : packets) {
+        assembler.insert(std::move(packet));
+        while (auto frame = contiguous ? assembler.pop_assembled_frame_contiguous() : assembler.pop_assembled_frame()) {
+            copied += copied_bytes(*frame);
+            keep(frame->length);
+            frames++;
+        }
+    }
+    double ns = stopwatch.elapsed_ns();
+    printf("%-12s frames=%zu  %.0f ns/frame  %.0f copied bytes/frame\n",
+        name, frames, ns / frames, static_cast<double>(copied) / frames);
+}
+
+void bench_loss(const char* name, int loss_percent, bool burst)
+{
+    auto packets = make_lossy_stream(loss_percent, burst);
+    const size_t inserted = packets.size();
+    FrameAssembler assembler { 512, 2048 };
+    size_t frames = 0;
+    Stopwatch stopwatch;
+    for (auto& packet : packets) {
+        assembler.insert(std::move(packet));
+        while (auto frame = assembler.pop_assembled_frame()) {
+            keep(frame->length);
+            frames++;
+        }
+    }
+    const double ns = stopwatch.elapsed_ns();
+    printf("%-12s loss %2d%%  packets=%zu  frames=%zu  %.0f ns/packet\n", name, loss_percent, inserted, frames, ns / inserted);
+}
+
+void bench_frame_size(int packets_per_frame)
+{
+    constexpr int kPackets = 160000;
+    auto packets = make_stream(kPackets / packets_per_frame, packets_per_frame, kSmallPayloadSize);
+    const size_t inserted = packets.size();
+    FrameAssembler assembler { 512, 2048 };
+    size_t frames = 0;
+    Stopwatch stopwatch;
+    for (auto& packet : packets) {
+        assembler.insert(std::move(packet));
+        while (auto frame = assembler.pop_assembled_frame()) {
+            keep(frame->length);
+            frames++;
+        }
+    }
+    const double ns = stopwatch.elapsed_ns();
+    printf("%3d packets/frame  frames=%zu  %.0f ns/packet\n", packets_per_frame, frames, ns / inserted);
+}
+
+} // namespace
+
+int main()
+{
+    printf("frame hand-off, %d byte payloads\n", static_cast<int>(kPayloadSize));
+    bench_pop("slices", false);
+    bench_pop("contiguous", true);
+
+    printf("insert under loss\n");
+    for (int loss_percent : { 0, 5, 30 }) {
+        bench_loss("random", loss_percent, false);
+    }
+    bench_loss("burst", 5, true);
+    bench_loss("burst", 30, true);
+
+    printf("insert by frame size\n");
+    for (int packets_per_frame : { 1, 8, 64, 256 }) {
+        bench_frame_size(packets_per_frame);
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "benchmark_util.h"
+#include "video/frame_buffer/frame_buffer.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr int kFps = 240;
+constexpr uint32_t kTimestampStep = 90000 / kFps;
+constexpr int64_t kFrames = kFps * 600;
+constexpr int64_t kKeyframeInterval = kFps;
+// Frames arrive shuffled within groups of this many.
+constexpr int64_t kReorderWindow = 4;
+constexpr size_t kDecodedHistorySize = 1000;
+
+ReceivedFrame make_frame(int64_t id)
+{
+    const bool keyframe = id % kKeyframeInterval == 0;
+    ReceivedFrame frame {};
+    frame.id = id;
+    frame.timestamp = static_cast<uint32_t>(id * kTimestampStep);
+    frame.frame_type = keyframe ? VideoFrameType::VideoFrameKey : VideoFrameType::VideoFrameDelta;
+    frame.num_references = keyframe ? 0 : 1;
+    frame.references[0] = id - 1;
+    return frame;
+}
+
+// Arrival order of a 240 fps stream with |loss_percent| of the delta frames
+// lost, keyframes always make it.
+std::vector<ReceivedFrame> make_stream(int loss_percent)
+{
+    std::mt19937 rng { 1 };
+    std::vector<ReceivedFrame> frames;
+    frames.reserve(kFrames);
+    for (int64_t base = 0; base < kFrames; base += kReorderWindow) {
+        const size_t group_start = frames.size();
+        for (int64_t id = base; id < base + kReorderWindow; id++) {
+            if (id % kKeyframeInterval != 0 && static_cast<int>(rng() % 100) < loss_percent) {
+                continue;
+            }
+            frames.push_back(make_frame(id));
+        }
+        std::shuffle(frames.begin() + group_start, frames.end(), rng);
+    }
+    return frames;
+}
+
+void bench(int loss_percent)
+{
+    auto frames = make_stream(loss_percent);
+    const size_t inserted = frames.size();
+    FrameBuffer frame_buffer { kDecodedHistorySize };
+    size_t popped = 0;
+    Stopwatch stopwatch;
+    for (auto& frame : frames) {
+        frame_buffer.insert(std::move(frame));
+        while (auto decodable = frame_buffer.pop_decodable_frame()) {
+            keep(decodable->id);
+            popped++;
+        }
+    }
+    const double ns = stopwatch.elapsed_ns();
+    printf("loss %2d%%  inserted=%zu  popped=%zu  %.0f ns/frame\n", loss_percent, inserted, popped, ns / inserted);
+}
+
+} // namespace
+
+int main()
+{
+    printf("%d fps, keyframe every %lld frames, reordered within %lld frames\n",
+        kFps, static_cast<long long>(kKeyframeInterval), static_cast<long long>(kReorderWindow));
+    for (int loss_percent : { 0, 1, 5, 20 }) {
+        bench(loss_percent);
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <bco/net/proactor/select.h>
+#include <bco/net/udp.h>
+#include "transport/transport.h"
+
+namespace brtc::benchmark {
+
+// The only proactor brtc uses, so the numbers are those of select().
+using Proactor = bco::net::Select;
+using UdpSocket = bco::net::UdpSocket<Proactor>;
+
+inline bco::net::Address loopback_address(uint16_t port)
+{
+    return bco::net::Address { bco::net::IPv4 { "127.0.0.1" }, port };
+}
+
+inline UdpSocket open_socket(Proactor* proactor, uint16_t port)
+{
+    auto [socket, err] = UdpSocket::create(proactor, AF_INET);
+    if (err != 0) {
+        printf("create udp socket failed\n");
+        std::exit(-1);
+    }
+    socket.bind(loopback_address(port));
+    return socket;
+}
+
+// Counts the RTP packets |transport| receives, runs on its context.
+inline bco::Routine count_rtp_loop(Transport* transport, std::atomic<uint64_t>* received)
+{
+    while (true) {
+        (void)co_await transport->recv_rtp();
+        received->fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Waits until |received| reaches |expected| or stops moving for |timeout|,
+// datagrams dropped on the way never show up. Returns the last count.
+inline uint64_t wait_for_packets(const std::atomic<uint64_t>& received, uint64_t expected, std::chrono::milliseconds timeout)
+{
+    auto last_progress = std::chrono::steady_clock::now();
+    uint64_t count = received;
+    while (count < expected && std::chrono::steady_clock::now() - last_progress < timeout) {
+        std::this_thread::yield();
+        if (received != count) {
+            count = received;
+            last_progress = std::chrono::steady_clock::now();
+        }
+    }
+    return count;
+}
+
+// Holds a sender back while more than |max_in_flight| packets are on their way
+// to |received|. Packets that still have not arrived after |timeout| are
+// written off as lost, so a dropped datagram can not stall the sender.
+class InFlightLimiter {
+public:
+    InFlightLimiter(const std::atomic<uint64_t>& received, uint64_t max_in_flight, std::chrono::milliseconds timeout)
+        : received_(received)
+        , max_in_flight_(max_in_flight)
+        , timeout_(timeout)
+    {
+    }
+
+    // Before sending, |sent| packets went out so far.
+    void wait(uint64_t sent)
+    {
+        if (in_flight(sent, received_) <= static_cast<int64_t>(max_in_flight_)) {
+            return;
+        }
+        const uint64_t received = wait_for_packets(received_, sent - lost_ - max_in_flight_, timeout_);
+        if (in_flight(sent, received) > static_cast<int64_t>(max_in_flight_)) {
+            lost_ = sent - received;
+        }
+    }
+
+    uint64_t lost() const { return lost_; }
+
+private:
+    int64_t in_flight(uint64_t sent, uint64_t received) const
+    {
+        return static_cast<int64_t>(sent - lost_) - static_cast<int64_t>(received);
+    }
+
+private:
+    const std::atomic<uint64_t>& received_;
+    const uint64_t max_in_flight_;
+    const std::chrono::milliseconds timeout_;
+    uint64_t lost_ = 0;
+};
+
+} // namespace brtc::benchmark
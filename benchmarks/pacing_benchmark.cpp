@@ -0,0 +1,162 @@
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <vector>
+#include "benchmark_util.h"
+#include "common/buffer_pool.h"
+#include "pacing/pacer.h"
+#include "rtp/header_template.h"
+#include "video/packetizer/packetizer.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+std::atomic<uint64_t> g_allocations { 0 };
+} // namespace
+
+// Counts every heap allocation of the process, the array and nothrow forms
+// end up here too.
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc {};
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+constexpr int kFrames = 20000;
+constexpr int64_t kFrameIntervalUs = 16000;
+constexpr uint32_t kTimestampStep = 90 * kFrameIntervalUs / 1000;
+constexpr size_t kFrameSize = 20000;
+constexpr size_t kMaxDatagramSize = 1232;
+// Same as MediaSenderImpl, room for the header and its extensions.
+constexpr size_t kRtpHeaderReserve = 40;
+constexpr uint32_t kSsrc = 0x11223344;
+constexpr uint8_t kPayloadType = 127;
+
+// One IDR slice of |size| bytes in Annex-B.
+std::vector<uint8_t> make_frame(size_t size)
+{
+    std::vector<uint8_t> frame { 0, 0, 0, 1, 0x65 };
+    for (size_t i = frame.size(); i < size; i++) {
+        frame.push_back(static_cast<uint8_t>(i * 7 + 3) | 1);
+    }
+    return frame;
+}
+
+Pacer::Config unlimited_pacer_config()
+{
+    // The budget never runs out, process() sends everything queued.
+    Pacer::Config config;
+    config.pacing_rate_bps = 10'000'000'000;
+    return config;
+}
+
+// What MediaSenderImpl::pacing_loop() does with every encoded frame, from the
+// headers to handing the packets to the transport.
+class PacingPath {
+public:
+    PacingPath()
+        : packet_buffers_(kMaxDatagramSize, 1024)
+        , pacer_(unlimited_pacer_config(),
+              [this](std::span<const RtpPacket> packets) { send(packets); },
+              [](size_t) { return std::vector<RtpPacket> {}; })
+    {
+    }
+
+    void on_frame(const std::vector<uint8_t>& encoded, uint32_t timestamp, int64_t now_us)
+    {
+        Frame frame;
+        frame.type = Frame::UnderlyingType::kMemory;
+        frame.data = const_cast<uint8_t*>(encoded.data());
+        frame.length = static_cast<uint32_t>(encoded.size());
+        Packetizer::PayloadSizeLimits limits;
+        limits.max_payload_len = static_cast<int>(kMaxDatagramSize - kRtpHeaderReserve);
+        auto packetizer = Packetizer::create(frame, VideoCodecType::H264, limits);
+        const size_t count = packetizer->num_packets();
+        frame_packets_.clear();
+        frame_packets_.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            RtpGenericFrameDescriptor descriptor;
+            descriptor.SetFirstPacketInSubFrame(i == 0);
+            descriptor.SetLastPacketInSubFrame(i + 1 == count);
+            const RtpHeaderTemplate& header_template = header_template_for(descriptor);
+            RtpPacket& packet = frame_packets_.emplace_back(header_template.create(packet_buffers_, seq_number_++, timestamp));
+            header_template.write_extension<RtpGenericFrameDescriptorExtension00>(packet, descriptor);
+        }
+        const size_t written = packetizer->next_packets(frame_packets_);
+        pacer_.enqueue(std::span { frame_packets_ }.first(written), Pacer::Priority::kVideo);
+        frame_packets_.clear();
+        pacer_.process(now_us);
+    }
+
+    uint64_t packets_sent() const { return packets_sent_; }
+
+private:
+    const RtpHeaderTemplate& header_template_for(const RtpGenericFrameDescriptor& descriptor)
+    {
+        const uint8_t size = RtpGenericFrameDescriptorExtension00::value_size(descriptor);
+        for (const auto& header_template : header_templates_) {
+            if (header_template.extension_size(RtpGenericFrameDescriptorExtension00::id()) == size) {
+                return header_template;
+            }
+        }
+        RtpHeaderTemplate& header_template = header_templates_.emplace_back(kSsrc, kPayloadType);
+        header_template.add_extension<RtpGenericFrameDescriptorExtension00>(size);
+        return header_template;
+    }
+
+    // Stands in for Transport::send_rtp(), which gathers data() of every packet.
+    void send(std::span<const RtpPacket> packets)
+    {
+        for (const auto& packet : packets) {
+            keep(packet.data().size());
+        }
+        packets_sent_ += packets.size();
+    }
+
+private:
+    BufferPool packet_buffers_;
+    Pacer pacer_;
+    std::vector<RtpHeaderTemplate> header_templates_;
+    std::vector<RtpPacket> frame_packets_;
+    uint16_t seq_number_ = 0;
+    uint64_t packets_sent_ = 0;
+};
+
+} // namespace
+
+int main()
+{
+    const auto encoded = make_frame(kFrameSize);
+    PacingPath path;
+    // Warms up the pool, the templates and the vectors.
+    path.on_frame(encoded, 0, 0);
+    const uint64_t warmup_packets = path.packets_sent();
+    const uint64_t allocations_before = g_allocations.load();
+    Stopwatch stopwatch;
+    for (int i = 1; i <= kFrames; i++) {
+        path.on_frame(encoded, i * kTimestampStep, i * kFrameIntervalUs);
+    }
+    const double ns = stopwatch.elapsed_ns();
+    const uint64_t allocations = g_allocations.load() - allocations_before;
+    const uint64_t packets = path.packets_sent() - warmup_packets;
+    printf("pacing path, %zu byte frames, %llu packets\n", kFrameSize, static_cast<unsigned long long>(packets));
+    printf("%.0f ns/packet  %.2f allocations/packet\n", ns / packets, static_cast<double>(allocations) / packets);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <vector>
+#include "benchmark_util.h"
+#include "common/buffer_pool.h"
+#include "video/packetizer/packetizer.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr int kIterations = 200;
+constexpr size_t kMaxDatagramSize = 1232;
+constexpr size_t kRtpHeaderReserve = 40;
+constexpr size_t kSlicesPerFrame = 8;
+
+void append_nalu(std::vector<uint8_t>& frame, uint8_t header, size_t size)
+{
+    frame.insert(frame.end(), { 0, 0, 0, 1, header });
+    for (size_t i = 1; i < size; i++) {
+        // Never two zero bytes in a row, so no start code shows up by accident.
+        frame.push_back(static_cast<uint8_t>(i * 7 + 3) | 1);
+    }
+}
+
+// SPS, PPS and |kSlicesPerFrame| IDR slices adding up to about |size| bytes.
+std::vector<uint8_t> make_keyframe(size_t size)
+{
+    std::vector<uint8_t> frame;
+    append_nalu(frame, 0x67, 20);
+    append_nalu(frame, 0x68, 4);
+    for (size_t i = 0; i < kSlicesPerFrame; i++) {
+        append_nalu(frame, 0x65, size / kSlicesPerFrame);
+    }
+    return frame;
+}
+
+void bench(const char* name, const std::vector<uint8_t>& encoded, Packetizer::PayloadMode mode)
+{
+    BufferPool pool { kMaxDatagramSize, 1024 };
+    Frame frame;
+    frame.type = Frame::UnderlyingType::kMemory;
+    frame.data = const_cast<uint8_t*>(encoded.data());
+    frame.length = static_cast<uint32_t>(encoded.size());
+    Packetizer::PayloadSizeLimits limits;
+    limits.max_payload_len = static_cast<int>(kMaxDatagramSize - kRtpHeaderReserve);
+    std::vector<RtpPacket> packets;
+    uint64_t total_packets = 0;
+    Stopwatch stopwatch;
+    for (int i = 0; i < kIterations; i++) {
+        auto packetizer = Packetizer::create(frame, VideoCodecType::H264, limits, mode);
+        const size_t count = packetizer->num_packets();
+        packets.clear();
+        for (size_t j = 0; j < count; j++) {
+            packets.push_back(RtpPacket::create(pool));
+        }
+        total_packets += packetizer->next_packets(packets);
+        keep(packets.back().size());
+    }
+    const double ns = stopwatch.elapsed_ns();
+    printf("%-18s %7zu bytes  %4llu packets  %.1f us/frame  %.0f ns/packet  %.2f GB/s\n", name, encoded.size(),
+        static_cast<unsigned long long>(total_packets / kIterations), ns / kIterations / 1e3, ns / total_packets,
+        static_cast<double>(encoded.size()) * kIterations / ns);
+}
+
+} // namespace
+
+int main()
+{
+    // Typical IDR sizes at high quality.
+    const auto keyframe_1080p = make_keyframe(150 * 1024);
+    const auto keyframe_4k = make_keyframe(600 * 1024);
+    bench("1080p copy", keyframe_1080p, Packetizer::PayloadMode::kCopy);
+    bench("1080p reference", keyframe_1080p, Packetizer::PayloadMode::kReference);
+    bench("4K copy", keyframe_4k, Packetizer::PayloadMode::kCopy);
+    bench("4K reference", keyframe_4k, Packetizer::PayloadMode::kReference);
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <bco/context.h>
+#include <brtc/interface.h>
+#include "benchmark_util.h"
+#include "loopback_util.h"
+#include "transport/transport.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr uint16_t kBasePort = 48000;
+constexpr size_t kClientsPerShard = 16;
+constexpr size_t kPacketSize = 1200;
+constexpr uint64_t kPacketsPerShard = 200000;
+// Per shard, keeps its socket buffer from overflowing.
+constexpr uint64_t kMaxInFlight = 256;
+constexpr auto kDrainTimeout = std::chrono::milliseconds { 1000 };
+
+std::unique_ptr<Proactor> make_proactor()
+{
+    auto proactor = std::make_unique<Proactor>();
+    proactor->start(std::make_unique<bco::SimpleExecutor>());
+    return proactor;
+}
+
+// Shard sockets have to allow port reuse before they are bound.
+UdpSocket open_shard_socket(Proactor* proactor, uint16_t port)
+{
+    auto [socket, err] = UdpSocket::create(proactor, AF_INET);
+    if (err != 0 || !SessionHost::enable_reuse_port(socket)) {
+        printf("create shard socket failed\n");
+        std::exit(-1);
+    }
+    socket.bind(loopback_address(port));
+    return socket;
+}
+
+bco::Buffer make_rtp_packet()
+{
+    bco::Buffer packet(kPacketSize);
+    packet[0] = 0x80;
+    packet[1] = 96;
+    packet.write_big_endian_at(8, 1u);
+    return packet;
+}
+
+struct Client {
+    UdpSocket socket;
+    bco::net::Address addr;
+};
+
+// Each shard is fed by a sender thread of its own, from the clients the host
+// assigned to it. Nothing is torn down, the sessions keep running until the
+// process exits.
+double bench(size_t shard_count, uint16_t& next_port)
+{
+    const uint16_t host_port = next_port++;
+    const auto host_addr = loopback_address(host_port);
+    std::vector<SessionHost::Shard> shards;
+    std::vector<std::shared_ptr<bco::Context>> contexts;
+    for (size_t i = 0; i < shard_count; i++) {
+        auto proactor = make_proactor();
+        UdpSocket socket = open_shard_socket(proactor.get(), host_port);
+        auto context = std::make_shared<bco::Context>(std::make_unique<bco::SimpleExecutor>());
+        context->add_proactor(std::move(proactor));
+        contexts.push_back(context);
+        shards.push_back(SessionHost::Shard { .socket = socket, .context = context, .core = static_cast<int>(i) });
+    }
+    auto host = new SessionHost { std::move(shards) };
+
+    auto client_proactor = make_proactor().release();
+    auto received = new std::vector<std::atomic<uint64_t>>(shard_count);
+    std::vector<std::vector<Client>> clients(shard_count);
+    for (size_t i = 0; i < shard_count * kClientsPerShard; i++) {
+        const auto addr = loopback_address(next_port);
+        Client client { open_socket(client_proactor, next_port++), addr };
+        const size_t shard = host->shard_of(addr);
+        auto transport = new Transport { host->context(addr), host->transport_info(addr) };
+        host->context(addr)->spawn(std::bind(count_rtp_loop, transport, &(*received)[shard]));
+        clients[shard].push_back(client);
+    }
+    host->start();
+    for (auto& context : contexts) {
+        context->start();
+    }
+
+    const auto packet = make_rtp_packet();
+    std::vector<uint64_t> delivered(shard_count);
+    std::vector<std::thread> senders;
+    Stopwatch stopwatch;
+    for (size_t shard = 0; shard < shard_count; shard++) {
+        if (clients[shard].empty()) {
+            continue;
+        }
+        senders.emplace_back([&, shard]() {
+            auto& shard_clients = clients[shard];
+            InFlightLimiter limiter { (*received)[shard], kMaxInFlight, kDrainTimeout };
+            for (uint64_t sent = 0; sent < kPacketsPerShard; sent++) {
+                limiter.wait(sent);
+                shard_clients[sent % shard_clients.size()].socket.sendto(packet, host_addr);
+            }
+            delivered[shard] = wait_for_packets((*received)[shard], kPacketsPerShard, kDrainTimeout);
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    const double wall_seconds = stopwatch.elapsed_s();
+    uint64_t total = 0;
+    for (uint64_t count : delivered) {
+        total += count;
+    }
+    // Clients are spread by source port, a shard that got none stays idle.
+    printf("shards=%3zu  busy=%3zu  received=%llu  %.0f packets/s", shard_count, senders.size(),
+        static_cast<unsigned long long>(total), total / wall_seconds);
+    return total / wall_seconds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    init_sockets();
+    const size_t max_shards = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::max(std::thread::hardware_concurrency(), 1u);
+    printf("one loopback port, %zu sessions per shard on average, one sender thread per busy shard, %zu byte RTP packets\n", kClientsPerShard, kPacketSize);
+    uint16_t next_port = kBasePort;
+    // Doubling the shards each round keeps the number of ports used low.
+    double baseline = 0;
+    for (size_t shards = 1;; shards = std::min(shards * 2, max_shards)) {
+        const double rate = bench(shards, next_port);
+        if (shards == 1) {
+            baseline = rate;
+        }
+        printf("  %.2fx\n", rate / baseline);
+        if (shards >= max_shards) {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <bco/context.h>
+#include "benchmark_util.h"
+#include "loopback_util.h"
+#include "transport/transport.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr uint16_t kBasePort = 46000;
+constexpr size_t kPacketSize = 1200;
+constexpr uint64_t kPacketsPerRound = 200000;
+// Keeps the socket buffers from overflowing.
+constexpr uint64_t kMaxInFlight = 256;
+constexpr auto kDrainTimeout = std::chrono::milliseconds { 1000 };
+
+// The transports keep running on their context after the round, they are
+// only released when the process exits.
+struct Round {
+    std::shared_ptr<bco::Context> context;
+    std::vector<std::unique_ptr<Transport>> transports;
+    std::atomic<uint64_t> received { 0 };
+};
+
+bco::Buffer make_rtp_packet()
+{
+    bco::Buffer packet(kPacketSize);
+    packet[0] = 0x80;
+    packet[1] = 96;
+    packet.write_big_endian_at(8, 1u);
+    return packet;
+}
+
+void bench(size_t sessions, uint16_t& next_port)
+{
+    auto proactor = std::make_unique<Proactor>();
+    proactor->start(std::make_unique<bco::SimpleExecutor>());
+    auto round = new Round;
+    round->context = std::make_shared<bco::Context>(std::make_unique<bco::SimpleExecutor>());
+
+    const auto sender_addr = loopback_address(next_port);
+    UdpSocket sender = open_socket(proactor.get(), next_port++);
+    std::vector<bco::net::Address> receivers;
+    for (size_t i = 0; i < sessions; i++) {
+        receivers.push_back(loopback_address(next_port));
+        TransportInfo info { .socket = open_socket(proactor.get(), next_port++), .remote_addr = sender_addr };
+        round->transports.push_back(std::make_unique<Transport>(round->context, info));
+        round->context->spawn(std::bind(count_rtp_loop, round->transports.back().get(), &round->received));
+    }
+    round->context->add_proactor(std::move(proactor));
+    round->context->start();
+
+    auto packet = make_rtp_packet();
+    const double cpu_start = process_cpu_seconds();
+    InFlightLimiter limiter { round->received, kMaxInFlight, kDrainTimeout };
+    Stopwatch stopwatch;
+    for (uint64_t sent = 0; sent < kPacketsPerRound; sent++) {
+        limiter.wait(sent);
+        sender.sendto(packet, receivers[sent % sessions]);
+    }
+    const uint64_t received = wait_for_packets(round->received, kPacketsPerRound, kDrainTimeout);
+    const double cpu_seconds = process_cpu_seconds() - cpu_start;
+    const double wall_seconds = stopwatch.elapsed_s();
+    printf("sessions=%4zu  received=%llu  %.0f packets/s  %.0f ns cpu/packet\n",
+        sessions, static_cast<unsigned long long>(received), received / wall_seconds, cpu_seconds * 1e9 / received);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    init_sockets();
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; i++) {
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (counts.empty()) {
+        counts = { 1, 16, 64, 256 };
+    }
+    printf("loopback sessions on one select() context, %zu byte RTP packets, cpu includes the sender\n", kPacketSize);
+    uint16_t next_port = kBasePort;
+    for (size_t sessions : counts) {
+        bench(sessions, next_port);
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <bco/context.h>
+#include <bco/coroutine/channel.h>
+#include "benchmark_util.h"
+#include "common/spsc_ring.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr int kItems = 20000;
+// Roughly a 240 fps stream per consumer wakeup, so the consumer parks between
+// items the way a decoder context does.
+constexpr auto kPushInterval = std::chrono::microseconds { 50 };
+
+struct Item {
+    int64_t sent_ns = 0;
+};
+
+struct Latencies {
+    std::vector<int64_t> samples;
+    std::atomic<bool> done { false };
+};
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void record(Latencies* latencies, const Item& item)
+{
+    latencies->samples.push_back(now_ns() - item.sent_ns);
+    if (latencies->samples.size() == kItems) {
+        latencies->done = true;
+    }
+}
+
+bco::Routine ring_consumer(SpscRing<Item>* ring, Latencies* latencies)
+{
+    while (true) {
+        record(latencies, co_await ring->pop());
+    }
+}
+
+bco::Routine channel_consumer(bco::Channel<Item>* channel, Latencies* latencies)
+{
+    while (true) {
+        record(latencies, co_await channel->recv());
+    }
+}
+
+void produce(const std::function<void(Item)>& push, const Latencies& latencies)
+{
+    for (int i = 0; i < kItems; i++) {
+        auto next = std::chrono::steady_clock::now() + kPushInterval;
+        push(Item { now_ns() });
+        while (std::chrono::steady_clock::now() < next) {
+            std::this_thread::yield();
+        }
+    }
+    while (!latencies.done) {
+        std::this_thread::yield();
+    }
+}
+
+void print(const char* name, std::vector<int64_t> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) { return samples[static_cast<size_t>(p * (samples.size() - 1))]; };
+    printf("%-12s p50 %lld ns  p99 %lld ns  max %lld ns\n", name,
+        static_cast<long long>(percentile(0.5)), static_cast<long long>(percentile(0.99)), static_cast<long long>(samples.back()));
+}
+
+} // namespace
+
+int main()
+{
+    // Each consumer keeps its context, the routines never return.
+    auto ring_latencies = new Latencies;
+    auto ring = new SpscRing<Item>({ 64, SpscRing<Item>::ShedPolicy::kNone, 64, {} });
+    auto ring_ctx = std::make_shared<bco::Context>(std::make_unique<bco::SimpleExecutor>());
+    ring_ctx->spawn(std::bind(ring_consumer, ring, ring_latencies));
+    ring_ctx->start();
+    produce([ring](Item item) { ring->push(item); }, *ring_latencies);
+
+    auto channel_latencies = new Latencies;
+    auto channel = new bco::Channel<Item>;
+    auto channel_ctx = std::make_shared<bco::Context>(std::make_unique<bco::SimpleExecutor>());
+    channel_ctx->spawn(std::bind(channel_consumer, channel, channel_latencies));
+    channel_ctx->start();
+    produce([channel](Item item) { channel->send(item); }, *channel_latencies);
+
+    printf("handoff latency, one item every %lld us\n", static_cast<long long>(kPushInterval.count()));
+    print("SpscRing", ring_latencies->samples);
+    print("bco::Channel", channel_latencies->samples);
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "benchmark_util.h"
+#include "common/ssrc_map.h"
+
+using namespace brtc;
+using namespace brtc::benchmark;
+
+namespace {
+
+constexpr size_t kLookups = 4096;
+constexpr int kRounds = 5000;
+
+// Packets arrive for random streams out of |ssrcs|.
+std::vector<uint32_t> make_lookups(const std::vector<uint32_t>& ssrcs, std::mt19937& rng)
+{
+    std::vector<uint32_t> lookups;
+    for (size_t i = 0; i < kLookups; i++) {
+        lookups.push_back(ssrcs[rng() % ssrcs.size()]);
+    }
+    return lookups;
+}
+
+template <typename Map, typename Find>
+double bench(const Map& map, const std::vector<uint32_t>& lookups, Find find)
+{
+    size_t hits = 0;
+    Stopwatch stopwatch;
+    for (int round = 0; round < kRounds; round++) {
+        for (uint32_t ssrc : lookups) {
+            hits += find(map, ssrc);
+        }
+    }
+    keep(hits);
+    return stopwatch.elapsed_ns() / (static_cast<double>(kRounds) * lookups.size());
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 rng { 1 };
+    printf("lookup of a known SSRC\n");
+    for (size_t count : { 1, 10, 100, 1000 }) {
+        std::vector<uint32_t> ssrcs;
+        SsrcMap<int> ssrc_map;
+        std::unordered_map<uint32_t, int> unordered_map;
+        while (ssrcs.size() < count) {
+            const uint32_t ssrc = rng();
+            if (ssrc_map.insert(ssrc, 0)) {
+                unordered_map.emplace(ssrc, 0);
+                ssrcs.push_back(ssrc);
+            }
+        }
+        const auto lookups = make_lookups(ssrcs, rng);
+        const double ssrc_map_ns = bench(ssrc_map, lookups, [](const SsrcMap<int>& map, uint32_t ssrc) { return map.find(ssrc) != nullptr; });
+        const double unordered_map_ns = bench(unordered_map, lookups, [](const std::unordered_map<uint32_t, int>& map, uint32_t ssrc) { return map.find(ssrc) != map.end(); });
+        printf("ssrcs=%4zu  SsrcMap %.2f ns  std::unordered_map %.2f ns\n", count, ssrc_map_ns, unordered_map_ns);
+    }
+    return 0;
+}
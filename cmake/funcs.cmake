@@ -33,4 +33,29 @@ function(add_brtc_object object_name ide_folder)
             ${PUBLIC_INCLUDE_DIR}
             ${SRC_DIR}
     )
-endfunction(add_brtc_object)
\ No newline at end of file
+endfunction(add_brtc_object)
+
+
+function(add_brtc_benchmark benchmark_name)
+    add_executable(${benchmark_name} ${ARGN})
+    set_target_properties(${benchmark_name}
+        PROPERTIES
+            FOLDER "benchmarks"
+            RUNTIME_OUTPUT_DIRECTORY ${BRTC_OUTPUT_DIR}
+    )
+    target_compile_definitions(${benchmark_name} PUBLIC
+        WIN32_LEAN_AND_MEAN
+        NOMINMAX
+    )
+    # Benchmarks drive internal components directly.
+    target_include_directories(${benchmark_name}
+        PRIVATE
+            ${SRC_DIR}
+            ${CMAKE_CURRENT_SOURCE_DIR}
+    )
+    target_link_libraries(${benchmark_name}
+        bco
+        brtc::brtc
+        glog::glog
+    )
+endfunction(add_brtc_benchmark)
@@ -1,3 +1,4 @@
 #pragma once
 #include <brtc/interface.h>
 #include <brtc/frame.h>
+#include <brtc/executor.h>
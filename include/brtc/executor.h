@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <bco/context.h>
+
+namespace brtc {
+
+class WorkStealingPoolImpl;
+
+// Worker threads shared by the contexts of many sessions. Every executor made
+// by create_executor() runs its tasks one at a time and in order, like a
+// SimpleExecutor, so a bco::Context on it stays single threaded. Which worker
+// runs them is up to the pool: idle workers steal executors with queued tasks
+// from busy ones, and a coroutine woken from a worker runs next on that same
+// worker.
+class WorkStealingPool {
+public:
+    // One worker per hardware thread for 0.
+    explicit WorkStealingPool(size_t workers = 0);
+    // Joins the workers, queued tasks are dropped.
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t worker_count() const;
+    // |worker| keeps everything the executor runs on that worker and out of
+    // reach of stealing, for network loops that should not move between
+    // cores. -1 lets any worker run it.
+    std::unique_ptr<bco::ExecutorInterface> create_executor(int worker = -1);
+
+private:
+    std::shared_ptr<WorkStealingPoolImpl> impl_;
+};
+
+} // namespace brtc
@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
 #include <any>
+#include <span>
+#include <vector>
 
 namespace brtc {
 
@@ -8,6 +10,7 @@ struct Frame {
     enum class UnderlyingType : uint32_t {
         kUknown,
         kMemory,
+        kMemorySlices,
         kD3D9Surface,
         kD3D11Texture2D,
         kOpenGLTexture2D,
@@ -18,7 +21,11 @@ struct Frame {
     uint32_t width = 0;
     uint32_t height = 0;
     uint32_t timestamp = 0; // ??
+    bool keyframe = false;
     std::any _data_holder;
+    // Only used by kMemorySlices, the frame is the concatenation of these
+    // slices and |length| is their total size.
+    std::vector<std::span<const uint8_t>> slices;
 };
 
 } // brtc
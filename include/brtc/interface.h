@@ -3,6 +3,7 @@
 #include <span>
 #include <vector>
 #include <memory>
+#include <tuple>
 
 //#include <bco/net/proactor/select.h>
 #include <bco/net/udp.h>
@@ -13,9 +14,106 @@
 namespace brtc
 {
 
+// Type-erased bco::net::UdpSocket, a session runs on whichever proactor the
+// socket was created with. brtc itself only uses bco::net::Select, it ships
+// no epoll or io_uring proactor.
+class AnyUdpSocket {
+public:
+    AnyUdpSocket() = default;
+    template <typename P>
+    AnyUdpSocket(bco::net::UdpSocket<P> socket)
+        : impl_ { std::make_shared<Impl<P>>(socket) }
+    {
+    }
+
+    bco::Task<std::tuple<int, bco::net::Address>> recvfrom(bco::Buffer buff) { return impl_->recvfrom(buff); }
+    int sendto(bco::Buffer buff, const bco::net::Address& addr) { return impl_->sendto(buff, addr); }
+    int fd() const { return impl_ ? impl_->fd() : -1; }
+
+private:
+    class Interface {
+    public:
+        virtual ~Interface() { }
+        virtual bco::Task<std::tuple<int, bco::net::Address>> recvfrom(bco::Buffer buff) = 0;
+        virtual int sendto(bco::Buffer buff, const bco::net::Address& addr) = 0;
+        virtual int fd() const = 0;
+    };
+
+    template <typename P>
+    class Impl : public Interface {
+    public:
+        Impl(bco::net::UdpSocket<P> socket)
+            : socket_ { socket }
+        {
+        }
+        bco::Task<std::tuple<int, bco::net::Address>> recvfrom(bco::Buffer buff) override { return socket_.recvfrom(buff); }
+        int sendto(bco::Buffer buff, const bco::net::Address& addr) override { return socket_.sendto(buff, addr); }
+        int fd() const override { return socket_.fd(); }
+
+    private:
+        bco::net::UdpSocket<P> socket_;
+    };
+
+private:
+    std::shared_ptr<Interface> impl_;
+};
+
+struct PathMtuConfig {
+    // Largest UDP payload sent or expected, 1472 on a 1500 byte ethernet MTU
+    // and 8972 with 9000 byte jumbo frames. Receive buffers are sized for it,
+    // so the receiving end needs at least the sender's value. Raised to 548,
+    // what every IPv4 path carries, if set lower.
+    size_t max_datagram_size = 1232;
+    // Off: packets may be |max_datagram_size| big right away. On: start from
+    // 1232 and search up to it with DF probes the peer acknowledges.
+    bool probe = false;
+};
+
+class SessionHostImpl;
+
 struct TransportInfo {
-    bco::net::UdpSocket<bco::net::Select> socket;
+    AnyUdpSocket socket;
     bco::net::Address remote_addr;
+    PathMtuConfig path_mtu;
+    // Set by SessionHost::transport_info(), |socket| is then shared with the
+    // other sessions of a shard and read by the host.
+    std::shared_ptr<SessionHostImpl> host;
+};
+
+// Runs many sessions on one UDP port spread over cores. Every shard has its
+// own socket, bound to the same address with SO_REUSEPORT, and its own
+// context. The kernel hands each datagram to the shard SessionHost assigns
+// its source to (Linux), so everything of a session stays on one core.
+class SessionHost {
+public:
+    struct Shard {
+        // enable_reuse_port() before binding. Shards are listed in the order
+        // their sockets were bound, the kernel numbers them that way.
+        AnyUdpSocket socket;
+        // Should run on one thread, a session is only used from there.
+        std::shared_ptr<bco::Context> context;
+        // Core the context's thread gets pinned to, -1 leaves it alone.
+        int core = -1;
+    };
+
+public:
+    SessionHost(std::vector<Shard>&& shards, const PathMtuConfig& path_mtu = {});
+    // Stops the host, its sessions receive nothing after that.
+    ~SessionHost();
+    SessionHost(const SessionHost&) = delete;
+    SessionHost& operator=(const SessionHost&) = delete;
+    static bool enable_reuse_port(const AnyUdpSocket& socket);
+    size_t shard_count() const;
+    size_t shard_of(const bco::net::Address& remote_addr) const;
+    // For a session with |remote_addr|, to be created with context() as its
+    // network context and destroyed on it.
+    TransportInfo transport_info(const bco::net::Address& remote_addr) const;
+    std::shared_ptr<bco::Context> context(const bco::net::Address& remote_addr) const;
+    void start();
+    void stop();
+
+private:
+    std::shared_ptr<SessionHostImpl> impl_;
 };
 
 class VideoCaptureInterface {
@@ -28,6 +126,7 @@ public:
 class VideoDecoderInterface {
 public:
     virtual ~VideoDecoderInterface() { }
+    // |frame| comes straight from the received packets as kMemorySlices.
     virtual Frame decode_one_frame(Frame frame) = 0;
 };
 
@@ -65,6 +164,9 @@ public:
         std::shared_ptr<bco::Context> network_ctx,
         std::shared_ptr<bco::Context> decode_ctx,
         std::shared_ptr<bco::Context> render_ctx);
+    // Gives the stream |ssrc| its own frame assembly and reference finding,
+    // call before start(). Packets of SSRCs not added share one pipeline.
+    void add_stream(uint32_t ssrc);
     void start();
     void stop();
 
@@ -91,4 +193,27 @@ private:
     std::shared_ptr<MediaSenderImpl> impl_;
 };
 
+class MediaForwarderImpl;
+
+// Relays RTP from one sender to many receivers without depacketizing it. Each
+// subscriber gets the packets of one source SSRC (simulcast layer) under its
+// own SSRC with contiguous sequence numbers and timestamps, the payload is
+// shared between subscribers and never copied.
+class MediaForwarder {
+public:
+    MediaForwarder(
+        const TransportInfo& info,
+        std::shared_ptr<bco::Context> network_ctx);
+    // Call before start().
+    void add_subscriber(const TransportInfo& info, uint32_t ssrc);
+    // Forwards |source_ssrc| to subscriber |subscriber_ssrc| from the next
+    // key frame of that source on. Safe to call while running.
+    void select_source(uint32_t subscriber_ssrc, uint32_t source_ssrc);
+    void start();
+    void stop();
+
+private:
+    std::shared_ptr<MediaForwarderImpl> impl_;
+};
+
 } // namespace brtc
@@ -1,5 +1,6 @@
 #include <array>
 #include <iostream>
+#include <memory>
 
 #include <mfxvideo.h>
 
@@ -79,6 +80,10 @@ int MfxDecoder::init2(Frame encoded_frame)
 
 Frame MfxDecoder::decode_one_frame(Frame encoded_frame)
 {
+    if (encoded_frame.type == Frame::UnderlyingType::kMemorySlices) {
+        // mfxBitstream needs contiguous memory, gather the slices once here.
+        encoded_frame = gather_slices(encoded_frame);
+    }
     Frame decoded_frame;
     int offset = 0;
     if (!already_init_) {
@@ -108,23 +113,19 @@ Frame MfxDecoder::decode_one_frame(Frame encoded_frame)
     if (status == MFX_ERR_NONE) {
         status = MFXVideoCORE_SyncOperation(mfx_session_, syncp, 100);
         if (status == MFX_ERR_NONE) {
-            delete encoded_frame.data;
             decoded_frame.data = surface_out->Data.MemId;
             decoded_frame.type = Frame::UnderlyingType::kD3D11Texture2D;
             decoded_frame.height = surface_out->Info.Height;
             decoded_frame.width = surface_out->Info.Width;
             return decoded_frame;
         }
-        delete encoded_frame.data;
         return decoded_frame;
         //sync and present surface_out, unlock?
     }
     if (status == MFX_ERR_MORE_DATA || status == MFX_ERR_MORE_SURFACE) {
-        delete encoded_frame.data;
         return decoded_frame;
     }
     //fatal error
-    delete encoded_frame.data;
     return decoded_frame;
 }
 
@@ -135,6 +136,26 @@ mfxStatus MfxDecoder::release_frame(ComPtr<ID3D11Texture2D> frame)
     return MFX_ERR_NONE;
 }
 
+Frame MfxDecoder::gather_slices(const Frame& encoded_frame)
+{
+    Frame frame;
+    frame.type = Frame::UnderlyingType::kMemory;
+    frame.width = encoded_frame.width;
+    frame.height = encoded_frame.height;
+    frame.timestamp = encoded_frame.timestamp;
+    frame.length = encoded_frame.length;
+    frame.keyframe = encoded_frame.keyframe;
+    auto frame_data = std::make_shared<std::vector<uint8_t>>(encoded_frame.length);
+    uint8_t* dst = frame_data->data();
+    for (auto slice : encoded_frame.slices) {
+        memcpy(dst, slice.data(), slice.size());
+        dst += slice.size();
+    }
+    frame.data = frame_data->data();
+    frame._data_holder = std::move(frame_data);
+    return frame;
+}
+
 int32_t MfxDecoder::get_unlocked_frame()
 {
     auto it = std::find_if(surfaces_.begin(), surfaces_.end(), [](const mfxFrameSurface1& surf) {
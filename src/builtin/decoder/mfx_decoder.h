@@ -32,6 +32,7 @@ public:
 
 private:
     int32_t get_unlocked_frame();
+    Frame gather_slices(const Frame& encoded_frame);
 
 private:
     bool already_init_ = false;
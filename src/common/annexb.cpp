@@ -0,0 +1,192 @@
+#include "common/annexb.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BRTC_ANNEXB_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BRTC_ANNEXB_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(BRTC_ANNEXB_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BRTC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BRTC_TARGET_AVX2
+#endif
+
+namespace brtc {
+
+namespace {
+
+// Start code at |pos| (the 00 00 01), widened to four bytes when the byte in
+// front of it is a zero too.
+StartCode start_code_at(std::span<const uint8_t> data, size_t pos)
+{
+    if (pos > 0 && data[pos - 1] == 0) {
+        return { pos - 1, 4 };
+    }
+    return { pos, 3 };
+}
+
+StartCode not_found(std::span<const uint8_t> data)
+{
+    return { data.size(), 0 };
+}
+
+// Looks at the third byte first, anything above 1 can not be part of a start
+// code ending there, so most of the time it moves three bytes at once.
+StartCode scan_scalar(std::span<const uint8_t> data, size_t from)
+{
+    const uint8_t* p = data.data();
+    const size_t size = data.size();
+    size_t i = from + 2;
+    while (i < size) {
+        if (p[i] > 1) {
+            i += 3;
+        } else if (p[i] == 1 && p[i - 1] == 0 && p[i - 2] == 0) {
+            return start_code_at(data, i - 2);
+        } else {
+            i++;
+        }
+    }
+    return not_found(data);
+}
+
+#if defined(BRTC_ANNEXB_X86)
+
+// Every lane i where data[i], data[i + 1], data[i + 2] are 00 00 01.
+StartCode scan_sse2(std::span<const uint8_t> data)
+{
+    constexpr size_t kLanes = 16;
+    const uint8_t* p = data.data();
+    const size_t size = data.size();
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    size_t i = 0;
+    for (; i + kLanes + 2 <= size; i += kLanes) {
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 1));
+        const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 2));
+        const __m128i hit = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, zero), _mm_cmpeq_epi8(b1, zero)), _mm_cmpeq_epi8(b2, one));
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (mask != 0) {
+#ifdef _MSC_VER
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+#else
+            const int bit = __builtin_ctz(mask);
+#endif
+            return start_code_at(data, i + bit);
+        }
+    }
+    return scan_scalar(data, i);
+}
+
+BRTC_TARGET_AVX2 StartCode scan_avx2(std::span<const uint8_t> data)
+{
+    constexpr size_t kLanes = 32;
+    const uint8_t* p = data.data();
+    const size_t size = data.size();
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for (; i + kLanes + 2 <= size; i += kLanes) {
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 1));
+        const __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 2));
+        const __m256i hit = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, zero), _mm256_cmpeq_epi8(b1, zero)), _mm256_cmpeq_epi8(b2, one));
+        const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask != 0) {
+#ifdef _MSC_VER
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+#else
+            const int bit = __builtin_ctz(mask);
+#endif
+            return start_code_at(data, i + bit);
+        }
+    }
+    return scan_scalar(data, i);
+}
+
+bool cpu_has_avx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    constexpr int kOsXsave = 1 << 27;
+    constexpr int kAvx = 1 << 28;
+    if ((info[2] & kOsXsave) == 0 || (info[2] & kAvx) == 0) {
+        return false;
+    }
+    // The OS has to save the YMM registers on context switches.
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    constexpr int kAvx2 = 1 << 5;
+    return (info[1] & kAvx2) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(BRTC_ANNEXB_NEON)
+
+StartCode scan_neon(std::span<const uint8_t> data)
+{
+    constexpr size_t kLanes = 16;
+    const uint8_t* p = data.data();
+    const size_t size = data.size();
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    size_t i = 0;
+    for (; i + kLanes + 2 <= size; i += kLanes) {
+        const uint8x16_t b0 = vld1q_u8(p + i);
+        const uint8x16_t b1 = vld1q_u8(p + i + 1);
+        const uint8x16_t b2 = vld1q_u8(p + i + 2);
+        const uint8x16_t hit = vandq_u8(vandq_u8(vceqq_u8(b0, zero), vceqq_u8(b1, zero)), vceqq_u8(b2, one));
+        // No movemask on NEON, find the lane in the rare block that has one.
+        if (vmaxvq_u8(hit) != 0) {
+            return scan_scalar(data.first(i + kLanes + 2), i);
+        }
+    }
+    return scan_scalar(data, i);
+}
+
+#endif
+
+using ScanFunc = StartCode (*)(std::span<const uint8_t>);
+
+ScanFunc select_scan()
+{
+#if defined(BRTC_ANNEXB_X86)
+    return cpu_has_avx2() ? scan_avx2 : scan_sse2;
+#elif defined(BRTC_ANNEXB_NEON)
+    return scan_neon;
+#else
+    return find_start_code_scalar;
+#endif
+}
+
+} // namespace
+
+StartCode find_start_code(std::span<const uint8_t> data)
+{
+    static const ScanFunc scan = select_scan();
+    return scan(data);
+}
+
+StartCode find_start_code_scalar(std::span<const uint8_t> data)
+{
+    return scan_scalar(data, 0);
+}
+
+} // namespace brtc
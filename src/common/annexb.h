@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace brtc {
+
+struct StartCode {
+    // Offset of the first zero byte of the start code.
+    size_t offset;
+    // 3 for 00 00 01, 4 for 00 00 00 01, 0 if there is none.
+    size_t length;
+};
+
+// Finds the first Annex-B start code in |data|, returns { data.size(), 0 } if
+// there is none. Uses AVX2 or SSE2 on x86 depending on the CPU, NEON on
+// arm64 and a scalar loop elsewhere.
+StartCode find_start_code(std::span<const uint8_t> data);
+
+// Always the scalar loop, for checking the vector paths against.
+StartCode find_start_code_scalar(std::span<const uint8_t> data);
+
+} // namespace brtc
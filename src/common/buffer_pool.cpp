@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include "common/buffer_pool.h"
+
+namespace brtc {
+
+struct BufferPool::Block {
+    bco::Buffer buffer;
+    std::atomic<uint32_t> refs { 0 };
+    Slab* slab = nullptr;
+};
+
+// The slab outlives the pool while leases are still out, it holds one
+// reference for the pool and one for every block in use.
+struct BufferPool::Slab {
+    Slab(size_t block_size, size_t capacity)
+        : blocks(new Block[capacity])
+    {
+        free_blocks.reserve(capacity);
+        for (size_t i = 0; i < capacity; i++) {
+            blocks[i].buffer = bco::Buffer { block_size };
+            blocks[i].slab = this;
+            free_blocks.push_back(&blocks[i]);
+        }
+        stats.capacity = capacity;
+    }
+
+    void release(Block* block)
+    {
+        {
+            std::lock_guard lock { mutex };
+            free_blocks.push_back(block);
+            stats.in_use--;
+        }
+        unref();
+    }
+
+    void unref()
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    std::unique_ptr<Block[]> blocks;
+    std::vector<Block*> free_blocks;
+    std::atomic<size_t> refs { 1 };
+    mutable std::mutex mutex;
+    Stats stats;
+};
+
+BufferPool::Lease::Lease(Block* block)
+    : block_(block)
+{
+    block_->refs.store(1, std::memory_order_relaxed);
+}
+
+BufferPool::Lease::Lease(const Lease& other)
+    : block_(other.block_)
+{
+    if (block_ != nullptr) {
+        block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+BufferPool::Lease::Lease(Lease&& other) noexcept
+    : block_(other.block_)
+{
+    other.block_ = nullptr;
+}
+
+BufferPool::Lease& BufferPool::Lease::operator=(const Lease& other)
+{
+    if (this != &other) {
+        if (other.block_ != nullptr) {
+            other.block_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        reset();
+        block_ = other.block_;
+    }
+    return *this;
+}
+
+BufferPool::Lease& BufferPool::Lease::operator=(Lease&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        block_ = other.block_;
+        other.block_ = nullptr;
+    }
+    return *this;
+}
+
+BufferPool::Lease::~Lease()
+{
+    reset();
+}
+
+void BufferPool::Lease::reset()
+{
+    if (block_ != nullptr && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        block_->slab->release(block_);
+    }
+    block_ = nullptr;
+}
+
+BufferPool::BufferPool(size_t block_size, size_t capacity)
+    : block_size_(block_size)
+    , slab_(new Slab { block_size, capacity })
+{
+}
+
+BufferPool::~BufferPool()
+{
+    slab_->unref();
+}
+
+std::tuple<bco::Buffer, BufferPool::Lease> BufferPool::acquire()
+{
+    Block* block = nullptr;
+    {
+        std::lock_guard lock { slab_->mutex };
+        if (slab_->free_blocks.empty()) {
+            slab_->stats.exhausted++;
+        } else {
+            block = slab_->free_blocks.back();
+            slab_->free_blocks.pop_back();
+            slab_->stats.in_use++;
+            slab_->stats.high_water_mark = std::max(slab_->stats.high_water_mark, slab_->stats.in_use);
+        }
+    }
+    if (block == nullptr) {
+        return { bco::Buffer { block_size_ }, Lease {} };
+    }
+    slab_->refs.fetch_add(1, std::memory_order_relaxed);
+    return { block->buffer, Lease { block } };
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+    std::lock_guard lock { slab_->mutex };
+    return slab_->stats;
+}
+
+} // namespace brtc
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <tuple>
+#include <bco/buffer.h>
+
+namespace brtc {
+
+// Fixed-capacity slab of equally sized bco::Buffer blocks. acquire() hands out
+// a block together with a refcounted Lease, the block goes back to the free
+// list when the last copy of the Lease is destroyed. The holder of a buffer
+// must keep its Lease for as long as it reads the buffer.
+class BufferPool {
+    struct Block;
+    struct Slab;
+
+public:
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(const Lease& other);
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(const Lease& other);
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+        explicit operator bool() const { return block_ != nullptr; }
+
+    private:
+        friend class BufferPool;
+        explicit Lease(Block* block);
+        void reset();
+
+    private:
+        Block* block_ = nullptr;
+    };
+
+    struct Stats {
+        size_t capacity = 0;
+        size_t in_use = 0;
+        size_t high_water_mark = 0;
+        // acquire() calls that found the pool empty and fell back to the heap.
+        size_t exhausted = 0;
+    };
+
+public:
+    BufferPool(size_t block_size, size_t capacity);
+    ~BufferPool();
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    std::tuple<bco::Buffer, Lease> acquire();
+    Stats stats() const;
+    size_t block_size() const { return block_size_; }
+
+private:
+    const size_t block_size_;
+    Slab* slab_;
+};
+
+} // namespace brtc
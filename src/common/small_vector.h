@@ -0,0 +1,117 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace brtc {
+
+// Vector that keeps up to |N| elements inline and only goes to the heap when
+// it grows past that. Limited to trivially copyable types, which is all it is
+// used for (NALU indexes, RTP extension entries), so growing and copying are
+// plain memcpy.
+template <typename T, size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    SmallVector() = default;
+    SmallVector(const SmallVector& other) { assign(other); }
+    SmallVector& operator=(const SmallVector& other)
+    {
+        if (this != &other) {
+            size_ = 0;
+            assign(other);
+        }
+        return *this;
+    }
+    SmallVector(SmallVector&& other) noexcept { take(other); }
+    SmallVector& operator=(SmallVector&& other) noexcept
+    {
+        if (this != &other) {
+            heap_.reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return heap_ ? capacity_ : N; }
+    T* data() { return heap_ ? heap_.get() : inline_; }
+    const T* data() const { return heap_ ? heap_.get() : inline_; }
+
+    T& operator[](size_t index)
+    {
+        assert(index < size_);
+        return data()[index];
+    }
+    const T& operator[](size_t index) const
+    {
+        assert(index < size_);
+        return data()[index];
+    }
+    T& front() { return (*this)[0]; }
+    const T& front() const { return (*this)[0]; }
+    T& back() { return (*this)[size_ - 1]; }
+    const T& back() const { return (*this)[size_ - 1]; }
+
+    T* begin() { return data(); }
+    T* end() { return data() + size_; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size_; }
+
+    void push_back(const T& value)
+    {
+        if (size_ == capacity()) {
+            reserve(capacity() * 2);
+        }
+        data()[size_++] = value;
+    }
+    void pop_back()
+    {
+        assert(size_ > 0);
+        size_--;
+    }
+    void clear() { size_ = 0; }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity <= this->capacity()) {
+            return;
+        }
+        auto heap = std::make_unique<T[]>(capacity);
+        std::memcpy(heap.get(), data(), size_ * sizeof(T));
+        heap_ = std::move(heap);
+        capacity_ = capacity;
+    }
+
+private:
+    void assign(const SmallVector& other)
+    {
+        reserve(other.size_);
+        std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+        size_ = other.size_;
+    }
+
+    void take(SmallVector& other)
+    {
+        if (other.heap_) {
+            heap_ = std::move(other.heap_);
+            capacity_ = other.capacity_;
+        } else {
+            std::memcpy(inline_, other.inline_, other.size_ * sizeof(T));
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+
+private:
+    T inline_[N];
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    std::unique_ptr<T[]> heap_;
+};
+
+} // namespace brtc
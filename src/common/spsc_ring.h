@@ -0,0 +1,268 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <bco/coroutine/channel.h>
+#include <bco/coroutine/task.h>
+
+namespace brtc {
+
+// Bounded lock-free single producer/single consumer ring for handing items
+// between two contexts. push() and try_pop() never block, pop() parks the
+// consumer coroutine on a bco::Channel which is only touched when the ring was
+// empty, so a busy pipeline never goes through the channel.
+// When the consumer falls behind, push() sheds items according to |policy|
+// instead of building latency, so a stalled consumer is handled where the
+// items keep arriving. Without a policy push() drops the new item if the ring
+// is full.
+//
+// Shedding queued items moves |head_| from the producer side, so both sides
+// advance it with a CAS. The consumer announces the slot it is moving an item
+// out of in |reading_| and the producer does not reuse that slot until it is
+// done, the item is discarded if it was shed meanwhile.
+template <typename T>
+class SpscRing {
+public:
+    enum class ShedPolicy : uint8_t {
+        kNone,
+        // Drop the oldest items to queue a new one beyond |max_backlog|.
+        kDropOldest,
+        // A delta item that would go beyond |max_backlog| is dropped, and so is
+        // every delta after it until the next key item. A key item is always
+        // queued, dropping everything queued before it if the backlog is full.
+        // A consumer never gets a delta item whose references were shed.
+        kDropNonKey,
+    };
+
+    struct Config {
+        size_t capacity = 64;
+        ShedPolicy policy = ShedPolicy::kNone;
+        size_t max_backlog = 64;
+        std::function<bool(const T&)> is_key;
+    };
+
+    struct Stats {
+        uint64_t pushed = 0;
+        uint64_t popped = 0;
+        uint64_t dropped_full = 0;
+        uint64_t shed = 0;
+    };
+
+public:
+    explicit SpscRing(Config config)
+        : config_(std::move(config))
+        , mask_(round_up_to_power_of_two(config_.capacity) - 1)
+        , slots_(mask_ + 1)
+    {
+        assert(config_.policy != ShedPolicy::kDropNonKey || config_.is_key);
+    }
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer side. False if |item| was dropped.
+    bool push(T item)
+    {
+        const uint64_t tail = tail_.value.load(std::memory_order_relaxed);
+        uint64_t head = producer_.cached_head;
+        if (tail - head >= limit()) {
+            head = head_.value.load(std::memory_order_acquire);
+        }
+        const bool admitted = admit(item, tail, head);
+        producer_.cached_head = head;
+        if (!admitted) {
+            return false;
+        }
+        if (tail - head > mask_) {
+            producer_.dropped_full.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // The slot last held item |tail - capacity()|, shed while the consumer
+        // was still moving it out.
+        while (tail > mask_ && reading_.value.load(std::memory_order_acquire) == tail - mask_) {
+            std::this_thread::yield();
+        }
+        slots_[tail & mask_] = std::move(item);
+        // seq_cst pairs with the consumer storing |parked_| before it re-reads
+        // |tail_|, one of the two sides always sees the other.
+        tail_.value.store(tail + 1, std::memory_order_seq_cst);
+        producer_.pushed.fetch_add(1, std::memory_order_relaxed);
+        if (parked_.value.load(std::memory_order_seq_cst) && parked_.value.exchange(false)) {
+            doorbell_.send(true);
+        }
+        return true;
+    }
+
+    // Consumer side.
+    std::optional<T> try_pop()
+    {
+        while (true) {
+            // Shedding may have moved |head_| past the tail cached here.
+            uint64_t head = head_.value.load(std::memory_order_acquire);
+            if (consumer_.cached_tail <= head) {
+                consumer_.cached_tail = tail_.value.load(std::memory_order_acquire);
+                if (consumer_.cached_tail == head) {
+                    return std::nullopt;
+                }
+            }
+            // seq_cst pairs with the producer moving |head_| before it reads
+            // |reading_|, either the item is still ours after this or the
+            // producer sees we are reading it.
+            reading_.value.store(head + 1, std::memory_order_seq_cst);
+            if (head_.value.load(std::memory_order_seq_cst) != head) {
+                reading_.value.store(0, std::memory_order_release);
+                continue;
+            }
+            T item = std::move(slots_[head & mask_]);
+            slots_[head & mask_] = T {};
+            const bool popped = head_.value.compare_exchange_strong(head, head + 1, std::memory_order_seq_cst);
+            reading_.value.store(0, std::memory_order_release);
+            if (popped) {
+                consumer_.popped.fetch_add(1, std::memory_order_relaxed);
+                return item;
+            }
+        }
+    }
+
+    bco::Task<T> pop()
+    {
+        while (true) {
+            if (auto item = try_pop()) {
+                co_return std::move(*item);
+            }
+            parked_.value.store(true, std::memory_order_seq_cst);
+            if (tail_.value.load(std::memory_order_seq_cst) == head_.value.load(std::memory_order_relaxed)) {
+                // A stale doorbell from an earlier race only costs one extra loop.
+                co_await doorbell_.recv();
+            } else {
+                parked_.value.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Approximate when called off the producer and consumer contexts.
+    size_t size() const
+    {
+        return static_cast<size_t>(tail_.value.load(std::memory_order_acquire) - head_.value.load(std::memory_order_acquire));
+    }
+
+    Stats stats() const
+    {
+        Stats stats;
+        stats.pushed = producer_.pushed.load(std::memory_order_relaxed);
+        stats.dropped_full = producer_.dropped_full.load(std::memory_order_relaxed);
+        stats.shed = producer_.shed.load(std::memory_order_relaxed);
+        stats.popped = consumer_.popped.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    static constexpr size_t kCacheLineSize = 64;
+
+    template <typename V>
+    struct alignas(kCacheLineSize) Padded {
+        std::atomic<V> value { 0 };
+    };
+
+    struct alignas(kCacheLineSize) ProducerState {
+        uint64_t cached_head = 0;
+        bool waiting_for_key = false;
+        std::atomic<uint64_t> pushed { 0 };
+        std::atomic<uint64_t> dropped_full { 0 };
+        std::atomic<uint64_t> shed { 0 };
+    };
+
+    struct alignas(kCacheLineSize) ConsumerState {
+        uint64_t cached_tail = 0;
+        std::atomic<uint64_t> popped { 0 };
+    };
+
+    static size_t round_up_to_power_of_two(size_t value)
+    {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Queued items beyond which |policy| sheds.
+    size_t limit() const
+    {
+        if (config_.policy == ShedPolicy::kNone) {
+            return mask_ + 1;
+        }
+        return std::clamp<size_t>(config_.max_backlog, 1, mask_ + 1);
+    }
+
+    // Applies |policy| before |item| is queued at |tail|, false if |item| is
+    // shed instead. |head| is kept current with what was dropped.
+    bool admit(const T& item, uint64_t tail, uint64_t& head)
+    {
+        switch (config_.policy) {
+        case ShedPolicy::kNone:
+            return true;
+        case ShedPolicy::kDropOldest:
+            while (tail - head >= limit()) {
+                drop_front(head, tail - limit() + 1);
+            }
+            return true;
+        case ShedPolicy::kDropNonKey:
+            if (config_.is_key(item)) {
+                producer_.waiting_for_key = false;
+                while (tail - head >= limit()) {
+                    drop_front(head, tail);
+                }
+                return true;
+            }
+            if (producer_.waiting_for_key || tail - head >= limit()) {
+                producer_.waiting_for_key = true;
+                producer_.shed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+        return true;
+    }
+
+    // Sheds the items from |head| up to |new_head|. Fails if the consumer
+    // popped meanwhile, |head| is then reloaded for the caller to retry.
+    bool drop_front(uint64_t& head, uint64_t new_head)
+    {
+        if (!head_.value.compare_exchange_strong(head, new_head, std::memory_order_seq_cst)) {
+            return false;
+        }
+        // Released right away rather than when overwritten, except the one
+        // the consumer may be moving out.
+        const uint64_t reading = reading_.value.load(std::memory_order_seq_cst);
+        for (uint64_t i = head; i < new_head; i++) {
+            if (reading != i + 1) {
+                slots_[i & mask_] = T {};
+            }
+        }
+        producer_.shed.fetch_add(new_head - head, std::memory_order_relaxed);
+        head = new_head;
+        return true;
+    }
+
+private:
+    const Config config_;
+    const size_t mask_;
+    std::vector<T> slots_;
+    Padded<uint64_t> head_;
+    Padded<uint64_t> tail_;
+    // One past the index of the item the consumer is moving out, 0 if none.
+    Padded<uint64_t> reading_;
+    Padded<bool> parked_;
+    ProducerState producer_;
+    ConsumerState consumer_;
+    bco::Channel<bool> doorbell_;
+};
+
+} // namespace brtc
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace brtc {
+
+// Map keyed by SSRC for the per packet stream lookup. Open addressing with
+// linear probing over a power of two table kept at most half full, slots
+// are found with a Fibonacci hash, so a lookup costs a multiply and a scan
+// of a few adjacent slots however many streams share the socket.
+template <typename T>
+class SsrcMap {
+public:
+    explicit SsrcMap(size_t capacity = kMinCapacity)
+    {
+        reset(capacity);
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T* find(uint32_t ssrc)
+    {
+        for (size_t i = slot_of(ssrc);; i = (i + 1) & mask_) {
+            Slot& slot = slots_[i];
+            if (!slot.used) {
+                return nullptr;
+            }
+            if (slot.ssrc == ssrc) {
+                return &slot.value;
+            }
+        }
+    }
+
+    const T* find(uint32_t ssrc) const
+    {
+        return const_cast<SsrcMap*>(this)->find(ssrc);
+    }
+
+    // False, leaving the map untouched, if |ssrc| is already there.
+    bool insert(uint32_t ssrc, T value)
+    {
+        if (find(ssrc) != nullptr) {
+            return false;
+        }
+        if ((size_ + 1) * 2 > slots_.size()) {
+            grow();
+        }
+        place(ssrc, std::move(value));
+        size_++;
+        return true;
+    }
+
+    bool erase(uint32_t ssrc)
+    {
+        size_t hole = slot_of(ssrc);
+        while (slots_[hole].used && slots_[hole].ssrc != ssrc) {
+            hole = (hole + 1) & mask_;
+        }
+        if (!slots_[hole].used) {
+            return false;
+        }
+        // Backward shift instead of tombstones: pull every later entry of
+        // the run that may live at the hole into it, so lookups still stop
+        // at the first free slot.
+        for (size_t i = (hole + 1) & mask_; slots_[i].used; i = (i + 1) & mask_) {
+            const size_t home = slot_of(slots_[i].ssrc);
+            if (((i - home) & mask_) >= ((i - hole) & mask_)) {
+                slots_[hole] = std::move(slots_[i]);
+                hole = i;
+            }
+        }
+        slots_[hole] = Slot {};
+        size_--;
+        return true;
+    }
+
+    template <typename F>
+    void for_each(F&& func)
+    {
+        for (auto& slot : slots_) {
+            if (slot.used) {
+                func(slot.ssrc, slot.value);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t kMinCapacity = 16;
+    static constexpr uint32_t kGoldenRatio = 0x9E3779B1;
+
+    struct Slot {
+        uint32_t ssrc = 0;
+        bool used = false;
+        T value {};
+    };
+
+    size_t slot_of(uint32_t ssrc) const
+    {
+        return static_cast<uint32_t>(ssrc * kGoldenRatio) >> shift_;
+    }
+
+    void reset(size_t capacity)
+    {
+        size_t size = kMinCapacity;
+        uint32_t bits = 4;
+        while (size < capacity) {
+            size *= 2;
+            bits++;
+        }
+        slots_.clear();
+        slots_.resize(size);
+        mask_ = size - 1;
+        shift_ = 32 - bits;
+    }
+
+    void place(uint32_t ssrc, T value)
+    {
+        size_t i = slot_of(ssrc);
+        while (slots_[i].used) {
+            i = (i + 1) & mask_;
+        }
+        slots_[i].ssrc = ssrc;
+        slots_[i].used = true;
+        slots_[i].value = std::move(value);
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old = std::move(slots_);
+        reset(old.size() * 2);
+        for (auto& slot : old) {
+            if (slot.used) {
+                place(slot.ssrc, std::move(slot.value));
+            }
+        }
+    }
+
+private:
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    uint32_t shift_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace brtc
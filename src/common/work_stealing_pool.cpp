@@ -0,0 +1,339 @@
+#include <algorithm>
+#include "common/work_stealing_pool.h"
+
+namespace brtc {
+
+namespace {
+// Tasks an executor runs before it goes to the back of the queue.
+constexpr size_t kMaxTasksPerRun = 32;
+// Runs in a row out of the LIFO slot, two executors waking each other could
+// otherwise keep a worker to themselves.
+constexpr uint32_t kMaxLifoStreak = 3;
+constexpr size_t kNotAWorker = static_cast<size_t>(-1);
+
+thread_local size_t tls_worker_index = kNotAWorker;
+thread_local const WorkStealingPoolImpl::Strand* tls_current_strand = nullptr;
+
+class StrandExecutor : public bco::ExecutorInterface {
+public:
+    StrandExecutor(std::shared_ptr<WorkStealingPoolImpl> pool, int worker)
+        : pool_(std::move(pool))
+        , strand_(std::make_shared<WorkStealingPoolImpl::Strand>(worker))
+    {
+    }
+
+    void post(std::function<void()>&& func) override
+    {
+        pool_->post(strand_, std::move(func));
+    }
+
+    void post_delay(std::chrono::microseconds duration, std::function<void()>&& func) override
+    {
+        pool_->post_delay(duration, strand_, std::move(func));
+    }
+
+    bool is_current_executor() override
+    {
+        return WorkStealingPoolImpl::is_current(strand_.get());
+    }
+
+    void start() override
+    {
+        // The pool's workers are already running.
+    }
+
+private:
+    std::shared_ptr<WorkStealingPoolImpl> pool_;
+    std::shared_ptr<WorkStealingPoolImpl::Strand> strand_;
+};
+} // namespace
+
+WorkStealingPoolImpl::WorkStealingPoolImpl(size_t workers)
+{
+    if (workers == 0) {
+        workers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    for (size_t i = 0; i < workers; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+WorkStealingPoolImpl::~WorkStealingPoolImpl()
+{
+    stop();
+}
+
+void WorkStealingPoolImpl::start()
+{
+    for (size_t i = 0; i < workers_.size(); i++) {
+        workers_[i]->thread = std::thread { &WorkStealingPoolImpl::worker_loop, this, i };
+    }
+    timer_thread_ = std::thread { &WorkStealingPoolImpl::timer_loop, this };
+}
+
+void WorkStealingPoolImpl::stop()
+{
+    if (stopping_.exchange(true)) {
+        return;
+    }
+    {
+        std::lock_guard lock { timer_mutex_ };
+    }
+    timer_cv_.notify_all();
+    if (timer_thread_.joinable()) {
+        timer_thread_.join();
+    }
+    for (size_t i = 0; i < workers_.size(); i++) {
+        wake(i);
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+size_t WorkStealingPoolImpl::worker_count() const
+{
+    return workers_.size();
+}
+
+bool WorkStealingPoolImpl::is_current(const Strand* strand)
+{
+    return tls_current_strand == strand;
+}
+
+void WorkStealingPoolImpl::post(const std::shared_ptr<Strand>& strand, std::function<void()>&& func)
+{
+    bool schedule = false;
+    {
+        std::lock_guard lock { strand->mutex };
+        strand->tasks.push_back(std::move(func));
+        schedule = !strand->scheduled;
+        strand->scheduled = true;
+    }
+    if (schedule) {
+        enqueue(std::shared_ptr<Strand> { strand });
+    }
+}
+
+void WorkStealingPoolImpl::post_delay(std::chrono::microseconds duration, const std::shared_ptr<Strand>& strand, std::function<void()>&& func)
+{
+    {
+        std::lock_guard lock { timer_mutex_ };
+        delayed_tasks_.push(DelayedTask { std::chrono::steady_clock::now() + duration, delayed_sequence_++, strand, std::move(func) });
+    }
+    timer_cv_.notify_one();
+}
+
+void WorkStealingPoolImpl::enqueue(std::shared_ptr<Strand>&& strand)
+{
+    if (strand->worker >= 0) {
+        const size_t index = static_cast<size_t>(strand->worker) % workers_.size();
+        {
+            std::lock_guard lock { workers_[index]->mutex };
+            workers_[index]->pinned.push_back(std::move(strand));
+        }
+        wake(index);
+        return;
+    }
+    if (tls_worker_index != kNotAWorker) {
+        // Woken by whatever this worker just ran, likely to touch the same
+        // data, so it goes next and the one it displaces becomes stealable.
+        Worker& worker = *workers_[tls_worker_index];
+        std::lock_guard lock { worker.mutex };
+        if (worker.lifo_slot) {
+            worker.stealable.push_back(std::move(worker.lifo_slot));
+        }
+        worker.lifo_slot = std::move(strand);
+    } else {
+        const size_t index = next_worker_++ % workers_.size();
+        {
+            std::lock_guard lock { workers_[index]->mutex };
+            workers_[index]->stealable.push_back(std::move(strand));
+        }
+        wake(index);
+    }
+    wake_one();
+}
+
+void WorkStealingPoolImpl::wake(size_t index)
+{
+    Worker& worker = *workers_[index];
+    if (worker.idle.exchange(false)) {
+        worker.wakeup.release();
+    }
+}
+
+void WorkStealingPoolImpl::wake_one()
+{
+    // Anyone idle can steal it.
+    for (size_t i = 0; i < workers_.size(); i++) {
+        Worker& worker = *workers_[i];
+        if (worker.idle.load() && worker.idle.exchange(false)) {
+            worker.wakeup.release();
+            return;
+        }
+    }
+}
+
+void WorkStealingPoolImpl::worker_loop(size_t index)
+{
+    tls_worker_index = index;
+    Worker& worker = *workers_[index];
+    while (!stopping_) {
+        auto strand = next_strand(index);
+        if (strand) {
+            run(index, std::move(strand));
+            continue;
+        }
+        // Announce going idle before the last look, a producer either sees
+        // the flag and wakes us or its work is found here.
+        worker.idle = true;
+        if (has_work(index) || stopping_) {
+            if (!worker.idle.exchange(false)) {
+                // Woken meanwhile, take the token back.
+                worker.wakeup.acquire();
+            }
+            continue;
+        }
+        worker.wakeup.acquire();
+    }
+    tls_worker_index = kNotAWorker;
+}
+
+std::shared_ptr<WorkStealingPoolImpl::Strand> WorkStealingPoolImpl::next_strand(size_t index)
+{
+    Worker& worker = *workers_[index];
+    {
+        std::lock_guard lock { worker.mutex };
+        if (worker.lifo_slot && worker.lifo_streak < kMaxLifoStreak) {
+            worker.lifo_streak++;
+            return std::move(worker.lifo_slot);
+        }
+        worker.lifo_streak = 0;
+        if (worker.lifo_slot) {
+            worker.stealable.push_back(std::move(worker.lifo_slot));
+        }
+        std::deque<std::shared_ptr<Strand>>* queue = nullptr;
+        if (!worker.pinned.empty()) {
+            queue = &worker.pinned;
+        } else if (!worker.stealable.empty()) {
+            queue = &worker.stealable;
+        }
+        if (queue != nullptr) {
+            auto strand = std::move(queue->front());
+            queue->pop_front();
+            return strand;
+        }
+    }
+    return steal(index);
+}
+
+std::shared_ptr<WorkStealingPoolImpl::Strand> WorkStealingPoolImpl::steal(size_t index)
+{
+    for (size_t i = 1; i < workers_.size(); i++) {
+        Worker& victim = *workers_[(index + i) % workers_.size()];
+        std::lock_guard lock { victim.mutex };
+        if (!victim.stealable.empty()) {
+            auto strand = std::move(victim.stealable.front());
+            victim.stealable.pop_front();
+            return strand;
+        }
+    }
+    return nullptr;
+}
+
+bool WorkStealingPoolImpl::has_work(size_t index)
+{
+    for (size_t i = 0; i < workers_.size(); i++) {
+        Worker& worker = *workers_[i];
+        std::lock_guard lock { worker.mutex };
+        if (!worker.stealable.empty() || (i == index && (worker.lifo_slot || !worker.pinned.empty()))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPoolImpl::run(size_t index, std::shared_ptr<Strand>&& strand)
+{
+    tls_current_strand = strand.get();
+    bool drained = false;
+    for (size_t i = 0; i < kMaxTasksPerRun && !drained; i++) {
+        std::function<void()> task;
+        {
+            std::lock_guard lock { strand->mutex };
+            if (strand->tasks.empty()) {
+                strand->scheduled = false;
+                drained = true;
+                continue;
+            }
+            task = std::move(strand->tasks.front());
+            strand->tasks.pop_front();
+        }
+        task();
+    }
+    tls_current_strand = nullptr;
+    if (!drained) {
+        std::lock_guard lock { strand->mutex };
+        if (strand->tasks.empty()) {
+            strand->scheduled = false;
+            drained = true;
+        }
+    }
+    if (!drained) {
+        // Out of budget, behind everything else queued on this worker.
+        Worker& worker = *workers_[index];
+        std::lock_guard lock { worker.mutex };
+        if (strand->worker >= 0) {
+            worker.pinned.push_back(std::move(strand));
+        } else {
+            worker.stealable.push_back(std::move(strand));
+        }
+    }
+}
+
+void WorkStealingPoolImpl::timer_loop()
+{
+    std::unique_lock lock { timer_mutex_ };
+    while (!stopping_) {
+        if (delayed_tasks_.empty()) {
+            timer_cv_.wait(lock);
+            continue;
+        }
+        const auto deadline = delayed_tasks_.top().deadline;
+        if (std::chrono::steady_clock::now() < deadline) {
+            timer_cv_.wait_until(lock, deadline);
+            continue;
+        }
+        DelayedTask task = std::move(const_cast<DelayedTask&>(delayed_tasks_.top()));
+        delayed_tasks_.pop();
+        lock.unlock();
+        post(task.strand, std::move(task.func));
+        lock.lock();
+    }
+}
+
+WorkStealingPool::WorkStealingPool(size_t workers)
+    : impl_ { std::make_shared<WorkStealingPoolImpl>(workers) }
+{
+    impl_->start();
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    impl_->stop();
+}
+
+size_t WorkStealingPool::worker_count() const
+{
+    return impl_->worker_count();
+}
+
+std::unique_ptr<bco::ExecutorInterface> WorkStealingPool::create_executor(int worker)
+{
+    return std::make_unique<StrandExecutor>(impl_, worker);
+}
+
+} // namespace brtc
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <semaphore>
+#include <thread>
+#include <vector>
+#include <brtc/executor.h>
+
+namespace brtc {
+
+class WorkStealingPoolImpl {
+public:
+    // The queue of one executor. Scheduled while it has tasks, and then in
+    // exactly one place: a worker's queue, its LIFO slot, or being run.
+    struct Strand {
+        explicit Strand(int _worker)
+            : worker(_worker)
+        {
+        }
+        const int worker;
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        bool scheduled = false;
+    };
+
+public:
+    explicit WorkStealingPoolImpl(size_t workers);
+    ~WorkStealingPoolImpl();
+    void start();
+    void stop();
+    size_t worker_count() const;
+    void post(const std::shared_ptr<Strand>& strand, std::function<void()>&& func);
+    void post_delay(std::chrono::microseconds duration, const std::shared_ptr<Strand>& strand, std::function<void()>&& func);
+    static bool is_current(const Strand* strand);
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Strand>> pinned;
+        std::deque<std::shared_ptr<Strand>> stealable;
+        // The strand last woken from this worker, run next unless it keeps
+        // getting there and starves the queue.
+        std::shared_ptr<Strand> lifo_slot;
+        uint32_t lifo_streak = 0;
+        std::atomic<bool> idle { false };
+        std::binary_semaphore wakeup { 0 };
+        std::thread thread;
+    };
+
+    struct DelayedTask {
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t sequence;
+        std::shared_ptr<Strand> strand;
+        std::function<void()> func;
+        bool operator>(const DelayedTask& other) const
+        {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+private:
+    void enqueue(std::shared_ptr<Strand>&& strand);
+    void wake(size_t index);
+    void wake_one();
+    void worker_loop(size_t index);
+    std::shared_ptr<Strand> next_strand(size_t index);
+    std::shared_ptr<Strand> steal(size_t index);
+    bool has_work(size_t index);
+    void run(size_t index, std::shared_ptr<Strand>&& strand);
+    void timer_loop();
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> stopping_ { false };
+    std::atomic<size_t> next_worker_ { 0 };
+    std::mutex timer_mutex_;
+    std::condition_variable timer_cv_;
+    std::priority_queue<DelayedTask, std::vector<DelayedTask>, std::greater<DelayedTask>> delayed_tasks_;
+    uint64_t delayed_sequence_ = 0;
+    std::thread timer_thread_;
+};
+
+} // namespace brtc
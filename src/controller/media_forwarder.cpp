@@ -0,0 +1,36 @@
+#include <brtc/interface.h>
+#include "transport/transport.h"
+#include "controller/media_forwarder_impl.h"
+
+namespace brtc {
+
+MediaForwarder::MediaForwarder(
+    const TransportInfo& info,
+    std::shared_ptr<bco::Context> network_ctx)
+    : impl_ { std::make_shared<MediaForwarderImpl>(
+        info,
+        network_ctx) }
+{
+}
+
+void MediaForwarder::add_subscriber(const TransportInfo& info, uint32_t ssrc)
+{
+    impl_->add_subscriber(info, ssrc);
+}
+
+void MediaForwarder::select_source(uint32_t subscriber_ssrc, uint32_t source_ssrc)
+{
+    impl_->select_source(subscriber_ssrc, source_ssrc);
+}
+
+void MediaForwarder::start()
+{
+    impl_->start();
+}
+
+void MediaForwarder::stop()
+{
+    impl_->stop();
+}
+
+} // namespace brtc
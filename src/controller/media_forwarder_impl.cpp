@@ -0,0 +1,136 @@
+#include <optional>
+#include "common/time_utils.h"
+#include "controller/media_forwarder_impl.h"
+
+namespace brtc {
+
+namespace {
+constexpr uint8_t kNaluTypeMask = 0x1F;
+constexpr uint8_t kFuAStartBit = 0x80;
+constexpr size_t kStapAFirstNaluOffset = 3;
+
+bool is_h264_key_nalu(uint8_t nalu_header)
+{
+    const uint8_t type = nalu_header & kNaluTypeMask;
+    return type == H264NaluType::Idr || type == H264NaluType::Sps;
+}
+
+// Looks at the first payload bytes only, a layer switch must not cost a
+// depacketization of every packet.
+bool starts_h264_keyframe(const RtpPacket& packet)
+{
+    const bco::Buffer payload = packet.payload();
+    if (payload.size() < 2) {
+        return false;
+    }
+    switch (payload[0] & kNaluTypeMask) {
+    case H264NaluType::StapA:
+        return payload.size() > kStapAFirstNaluOffset && is_h264_key_nalu(payload[kStapAFirstNaluOffset]);
+    case H264NaluType::FuA:
+        return (payload[1] & kFuAStartBit) != 0 && is_h264_key_nalu(payload[1]);
+    default:
+        return is_h264_key_nalu(payload[0]);
+    }
+}
+} // namespace
+
+MediaForwarderImpl::Subscriber::Subscriber(std::unique_ptr<Transport>&& _transport, uint32_t _ssrc)
+    : transport(std::move(_transport))
+    , ssrc(_ssrc)
+{
+}
+
+MediaForwarderImpl::MediaForwarderImpl(const TransportInfo& info, std::shared_ptr<bco::Context> network_ctx)
+    : transport_(std::make_unique<Transport>(network_ctx, info))
+    , network_ctx_(network_ctx)
+{
+}
+
+void MediaForwarderImpl::add_subscriber(const TransportInfo& info, uint32_t ssrc)
+{
+    subscribers_.push_back(std::make_unique<Subscriber>(std::make_unique<Transport>(network_ctx_, info), ssrc));
+}
+
+void MediaForwarderImpl::select_source(uint32_t subscriber_ssrc, uint32_t source_ssrc)
+{
+    for (auto& subscriber : subscribers_) {
+        if (subscriber->ssrc == subscriber_ssrc) {
+            subscriber->requested_source_ssrc = source_ssrc;
+        }
+    }
+}
+
+void MediaForwarderImpl::start()
+{
+    network_ctx_->spawn(std::bind(&MediaForwarderImpl::forward_loop, this, shared_from_this()));
+    network_ctx_->spawn(std::bind(&MediaForwarderImpl::discard_rtcp_loop, this, shared_from_this(), transport_.get()));
+    for (auto& subscriber : subscribers_) {
+        network_ctx_->spawn(std::bind(&MediaForwarderImpl::discard_rtp_loop, this, shared_from_this(), subscriber->transport.get()));
+        network_ctx_->spawn(std::bind(&MediaForwarderImpl::discard_rtcp_loop, this, shared_from_this(), subscriber->transport.get()));
+    }
+}
+
+void MediaForwarderImpl::stop()
+{
+    stop_ = true;
+}
+
+bco::Routine MediaForwarderImpl::forward_loop(std::shared_ptr<MediaForwarderImpl> that)
+{
+    while (!stop_) {
+        auto packet = co_await transport_->recv_rtp();
+        forward(packet, MachineNowMilliseconds());
+    }
+}
+
+bco::Routine MediaForwarderImpl::discard_rtp_loop(std::shared_ptr<MediaForwarderImpl> that, Transport* transport)
+{
+    while (!stop_) {
+        co_await transport->recv_rtp();
+    }
+}
+
+bco::Routine MediaForwarderImpl::discard_rtcp_loop(std::shared_ptr<MediaForwarderImpl> that, Transport* transport)
+{
+    while (!stop_) {
+        co_await transport->recv_rtcp();
+    }
+}
+
+void MediaForwarderImpl::forward(const RtpPacket& packet, int64_t now_ms)
+{
+    const uint32_t ssrc = packet.ssrc();
+    // Worked out once per packet, not per subscriber.
+    std::optional<bool> keyframe;
+    for (auto& subscriber : subscribers_) {
+        const uint32_t requested_source_ssrc = subscriber->requested_source_ssrc;
+        if (requested_source_ssrc == 0) {
+            continue;
+        }
+        if (ssrc != subscriber->source_ssrc) {
+            if (ssrc != requested_source_ssrc) {
+                continue;
+            }
+            if (!keyframe) {
+                keyframe = starts_h264_keyframe(packet);
+            }
+            if (!*keyframe) {
+                continue;
+            }
+            subscriber->source_ssrc = ssrc;
+            subscriber->rewriter.switch_source();
+        }
+        uint16_t sequence_number;
+        uint32_t timestamp;
+        if (!subscriber->rewriter.rewrite(packet.sequence_number(), packet.timestamp(), now_ms, sequence_number, timestamp)) {
+            continue;
+        }
+        RtpPacket outgoing = packet.share_payload();
+        outgoing.set_ssrc(subscriber->ssrc);
+        outgoing.set_sequence_number(sequence_number);
+        outgoing.set_timestamp(timestamp);
+        subscriber->transport->send_rtp(std::move(outgoing));
+    }
+}
+
+} // namespace brtc
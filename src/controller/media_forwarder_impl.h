@@ -0,0 +1,48 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <brtc/interface.h>
+#include <bco/context.h>
+#include "rtp/sequence_rewriter.h"
+#include "transport/transport.h"
+
+namespace brtc {
+
+class MediaForwarderImpl : public std::enable_shared_from_this<MediaForwarderImpl> {
+public:
+    MediaForwarderImpl(const TransportInfo& info, std::shared_ptr<bco::Context> network_ctx);
+    void add_subscriber(const TransportInfo& info, uint32_t ssrc);
+    void select_source(uint32_t subscriber_ssrc, uint32_t source_ssrc);
+    void start();
+    void stop();
+
+private:
+    struct Subscriber {
+        Subscriber(std::unique_ptr<Transport>&& _transport, uint32_t _ssrc);
+        std::unique_ptr<Transport> transport;
+        // Outgoing SSRC, the same whichever source is forwarded.
+        uint32_t ssrc;
+        // Source asked for by select_source(), taken over at its next key
+        // frame. 0 forwards nothing.
+        std::atomic<uint32_t> requested_source_ssrc { 0 };
+        uint32_t source_ssrc = 0;
+        SequenceRewriter rewriter;
+    };
+
+private:
+    bco::Routine forward_loop(std::shared_ptr<MediaForwarderImpl> that);
+    // Nothing consumes these yet, read so they do not queue for the whole
+    // session.
+    bco::Routine discard_rtp_loop(std::shared_ptr<MediaForwarderImpl> that, Transport* transport);
+    bco::Routine discard_rtcp_loop(std::shared_ptr<MediaForwarderImpl> that, Transport* transport);
+    void forward(const RtpPacket& packet, int64_t now_ms);
+
+private:
+    std::atomic<bool> stop_ { false };
+    std::unique_ptr<Transport> transport_;
+    std::shared_ptr<bco::Context> network_ctx_;
+    std::vector<std::unique_ptr<Subscriber>> subscribers_;
+};
+
+} // namespace brtc
@@ -23,6 +23,11 @@ MediaReceiver::MediaReceiver(
 {
 }
 
+void MediaReceiver::add_stream(uint32_t ssrc)
+{
+    impl_->add_stream(ssrc);
+}
+
 void MediaReceiver::start()
 {
     impl_->start();
@@ -7,6 +7,15 @@ namespace {
 constexpr size_t kStartPacketBufferSize = 512;
 constexpr size_t kMaxPacketBufferSize = 1000;
 constexpr size_t kDecodedHistorySize = 1000;
+constexpr size_t kUndecodedFrameQueueSize = 64;
+constexpr size_t kMaxUndecodedFrameBacklog = 8;
+constexpr size_t kDecodedFrameQueueSize = 8;
+constexpr size_t kMaxDecodedFrameBacklog = 2;
+
+bool is_keyframe(const brtc::Frame& frame)
+{
+    return frame.keyframe;
+}
 }
 
 
@@ -18,21 +27,40 @@ MediaReceiverImpl::MediaReceiverImpl(
                 std::shared_ptr<bco::Context> network_ctx,
                 std::shared_ptr<bco::Context> decode_ctx,
                 std::shared_ptr<bco::Context> render_ctx)
-    : transport_(std::make_unique<Transport>(network_ctx, info))
+    : transport_info_(info)
     , strategies_(std::move(strategies))
     , decoder_(std::move(decoder))
     , render_(std::move(render))
     , network_ctx_(network_ctx)
     , decode_ctx_(decode_ctx)
     , render_ctx_(render_ctx)
-    , frame_assembler_(kStartPacketBufferSize, kMaxPacketBufferSize)
-    , frame_buffer_(kDecodedHistorySize)
+    , undecoded_frames_({ kUndecodedFrameQueueSize, SpscRing<Frame>::ShedPolicy::kDropNonKey, kMaxUndecodedFrameBacklog, is_keyframe })
+    , decoded_frames_({ kDecodedFrameQueueSize, SpscRing<Frame>::ShedPolicy::kDropOldest, kMaxDecodedFrameBacklog, {} })
+{
+    streams_.push_back(std::make_unique<ReceiveStream>(std::nullopt));
+}
+
+MediaReceiverImpl::ReceiveStream::ReceiveStream(std::optional<uint32_t> _ssrc)
+    : ssrc(_ssrc)
+    , depacketizer(Depacketizer::create(VideoCodecType::H264))
+    , frame_assembler(kStartPacketBufferSize, kMaxPacketBufferSize)
+    , frame_buffer(kDecodedHistorySize)
 {
 }
 
+void MediaReceiverImpl::add_stream(uint32_t ssrc)
+{
+    for (const auto& stream : streams_) {
+        if (stream->ssrc == ssrc) {
+            return;
+        }
+    }
+    streams_.push_back(std::make_unique<ReceiveStream>(ssrc));
+}
+
 void MediaReceiverImpl::start()
 {
-    network_ctx_->spawn(std::bind(&MediaReceiverImpl::network_loop, this, shared_from_this()));
+    network_ctx_->spawn(std::bind(&MediaReceiverImpl::start_network, this, shared_from_this()));
     decode_ctx_->spawn(std::bind(&MediaReceiverImpl::decode_loop, this, shared_from_this()));
     render_ctx_->spawn(std::bind(&MediaReceiverImpl::render_loop, this, shared_from_this()));
 }
@@ -42,31 +70,60 @@ void MediaReceiverImpl::stop()
     stop_ = true;
 }
 
-bco::Routine MediaReceiverImpl::network_loop(std::shared_ptr<MediaReceiverImpl> that)
+bco::Routine MediaReceiverImpl::start_network(std::shared_ptr<MediaReceiverImpl> that)
+{
+    // The transport receives as soon as it exists, every stream is routed
+    // before this routine gives the network context back to it.
+    transport_ = std::make_unique<Transport>(network_ctx_, transport_info_);
+    for (auto& stream : streams_) {
+        if (stream->ssrc) {
+            transport_->add_rtp_stream(*stream->ssrc);
+        }
+        network_ctx_->spawn(std::bind(&MediaReceiverImpl::network_loop, this, that, stream.get()));
+    }
+    co_return;
+}
+
+bco::Routine MediaReceiverImpl::network_loop(std::shared_ptr<MediaReceiverImpl> that, ReceiveStream* stream)
 {
     while (!stop_) {
-        auto packet = co_await transport_->recv_rtp();
-        parse_rtp_extensions(packet);
-        frame_assembler_.insert(packet);
-        while (auto frame = frame_assembler_.pop_assembled_frame()) {
-            //TODO: Frame -> ReceivedFrame
-            std::unique_ptr<ReceivedFrame> received_frame;
-            reference_finder_.ManageFrame(std::move(received_frame));
+        auto packet = co_await receive_from_transport(*stream);
+        if (packet.empty_payload()) {
+            // Padding shares the sequence numbers of the media, it fills a
+            // gap instead of being a packet lost.
+            stream->frame_assembler.insert_padding(packet.sequence_number());
+            stream->reference_finder.PaddingReceived(packet.sequence_number());
+        } else {
+            if (!stream->depacketizer->parse(packet)) {
+                continue;
+            }
+            parse_rtp_extensions(packet);
+            stream->frame_assembler.insert(packet);
+        }
+        while (auto frame = stream->frame_assembler.pop_received_frame()) {
+            stream->reference_finder.ManageFrame(std::move(frame));
         }
-        while (auto frame = reference_finder_.pop_gop_inter_continous_frame()) {
-            frame_buffer_.insert(*frame);
+        // Frames are moved along, the payload slices still point into the
+        // received packets when they reach the decoder.
+        while (auto frame = stream->reference_finder.pop_gop_inter_continous_frame()) {
+            stream->frame_buffer.insert(std::move(*frame));
         }
-        while (auto frame = frame_buffer_.pop_decodable_frame()) {
-            send_to_decode_loop(frame.value());
+        while (auto frame = stream->frame_buffer.pop_decodable_frame()) {
+            send_to_decode_loop(std::move(*frame));
         }
     }
 }
 
+bco::Task<RtpPacket> MediaReceiverImpl::receive_from_transport(const ReceiveStream& stream)
+{
+    return stream.ssrc ? transport_->recv_rtp(*stream.ssrc) : transport_->recv_rtp();
+}
+
 bco::Routine MediaReceiverImpl::decode_loop(std::shared_ptr<MediaReceiverImpl> that)
 {
     while (!stop_) {
         auto undecoded_frame = co_await receive_from_network_loop();
-        auto decoded_frame = decode_one_frame(undecoded_frame);
+        auto decoded_frame = decode_one_frame(std::move(undecoded_frame));
         send_to_render_loop(decoded_frame);
     }
 }
@@ -81,27 +138,27 @@ bco::Routine MediaReceiverImpl::render_loop(std::shared_ptr<MediaReceiverImpl> t
 
 void MediaReceiverImpl::send_to_decode_loop(Frame frame)
 {
-    undecoded_frames_.send(frame);
+    undecoded_frames_.push(std::move(frame));
 }
 
 void MediaReceiverImpl::send_to_render_loop(Frame frame)
 {
-    decoded_frames_.send(frame);
+    decoded_frames_.push(std::move(frame));
 }
 
 bco::Task<Frame> MediaReceiverImpl::receive_from_network_loop()
 {
-    return undecoded_frames_.recv();
+    return undecoded_frames_.pop();
 }
 
 bco::Task<Frame> MediaReceiverImpl::receive_from_decode_loop()
 {
-    return decoded_frames_.recv();
+    return decoded_frames_.pop();
 }
 
 Frame MediaReceiverImpl::decode_one_frame(Frame frame)
 {
-    return decoder_->decode_one_frame(frame);
+    return decoder_->decode_one_frame(std::move(frame));
 }
 
 void MediaReceiverImpl::render_one_frame(Frame frame)
@@ -1,12 +1,16 @@
 #pragma once
 #include <memory>
 #include <deque>
+#include <optional>
+#include <vector>
 #include <atomic>
 #include <brtc/interface.h>
 #include <bco/coroutine/channel.h>
 #include <bco/net/proactor/select.h>
 #include <bco/context.h>
+#include "common/spsc_ring.h"
 #include "transport/transport.h"
+#include "video/depacketizer/depacketizer.h"
 #include "video/frame_assembler/frame_assembler.h"
 #include "video/frame_buffer/frame_buffer.h"
 #include "video/reference_finder/reference_finder.h"
@@ -23,11 +27,26 @@ public:
         std::shared_ptr<bco::Context> network_ctx,
         std::shared_ptr<bco::Context> decode_ctx,
         std::shared_ptr<bco::Context> render_ctx);
+    void add_stream(uint32_t ssrc);
     void start();
     void stop();
 
 private:
-    bco::Routine network_loop(std::shared_ptr<MediaReceiverImpl> that);
+    // Receive pipeline of one RTP stream.
+    struct ReceiveStream {
+        ReceiveStream(std::optional<uint32_t> ssrc);
+        // Empty for the stream that takes every SSRC not added.
+        std::optional<uint32_t> ssrc;
+        std::unique_ptr<Depacketizer> depacketizer;
+        FrameAssembler frame_assembler;
+        FrameBuffer frame_buffer;
+        RtpFrameReferenceFinder reference_finder;
+    };
+
+private:
+    bco::Routine start_network(std::shared_ptr<MediaReceiverImpl> that);
+    bco::Routine network_loop(std::shared_ptr<MediaReceiverImpl> that, ReceiveStream* stream);
+    bco::Task<RtpPacket> receive_from_transport(const ReceiveStream& stream);
     bco::Routine decode_loop(std::shared_ptr<MediaReceiverImpl> that);
     bco::Routine render_loop(std::shared_ptr<MediaReceiverImpl> that);
     inline void send_to_decode_loop(Frame frame);
@@ -40,6 +59,8 @@ private:
 
 private:
     std::atomic<bool> stop_ { false };
+    TransportInfo transport_info_;
+    // Created by start(), on the network context.
     std::unique_ptr<Transport> transport_;
     std::unique_ptr<Strategies> strategies_;
     std::unique_ptr<VideoDecoderInterface> decoder_;
@@ -47,11 +68,9 @@ private:
     std::shared_ptr<bco::Context> network_ctx_;
     std::shared_ptr<bco::Context> decode_ctx_;
     std::shared_ptr<bco::Context> render_ctx_;
-    FrameAssembler frame_assembler_;
-    FrameBuffer frame_buffer_;
-    RtpFrameReferenceFinder reference_finder_;
-    bco::Channel<Frame> undecoded_frames_;
-    bco::Channel<Frame> decoded_frames_;
+    std::vector<std::unique_ptr<ReceiveStream>> streams_;
+    SpscRing<Frame> undecoded_frames_;
+    SpscRing<Frame> decoded_frames_;
 };
 
 } // namespace brtc
\ No newline at end of file
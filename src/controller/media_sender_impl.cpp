@@ -2,10 +2,23 @@
 #include <bco/coroutine/cofunc.h>
 #include "media_sender_impl.h"
 #include "../video/packetizer/packetizer.h"
+#include "../common/time_utils.h"
 
 namespace {
 constexpr uint32_t kDefaultSsrc = 11223344;
 constexpr uint32_t kDefaultPayloadType = 127;
+constexpr size_t kMaxPaddingSize = 224;
+constexpr size_t kEncodedFrameQueueSize = 16;
+constexpr size_t kMaxEncodedFrameBacklog = 4;
+// Room for the fixed RTP header and the extensions in front of the payload.
+constexpr size_t kRtpHeaderReserve = 40;
+// Covers the pacer queue for a large keyframe plus the batch being sent.
+constexpr size_t kPacketBufferPoolCapacity = 1024;
+
+bool is_keyframe(const brtc::Frame& frame)
+{
+    return frame.keyframe;
+}
 }
 
 namespace brtc {
@@ -25,6 +38,12 @@ MediaSenderImpl::MediaSenderImpl(
     , network_ctx_(network_ctx)
     , encode_ctx_(encode_ctx)
     , pacer_ctx_(pacer_ctx)
+    , encoded_frames_({ kEncodedFrameQueueSize, SpscRing<Frame>::ShedPolicy::kDropNonKey, kMaxEncodedFrameBacklog, is_keyframe })
+    , packet_buffers_(datagram_size_ceiling(info.path_mtu), kPacketBufferPoolCapacity)
+    , padding_template_(kDefaultSsrc, kDefaultPayloadType)
+    , pacer_(Pacer::Config {},
+          [this](std::span<const RtpPacket> packets) { transport_->send_rtp(packets); },
+          [this](size_t bytes) { return create_padding_packets(bytes); })
 {
     start_timestamp_ = ::rand();
     seq_number_ = ::rand();
@@ -36,6 +55,7 @@ void MediaSenderImpl::start()
     network_ctx_->spawn(std::bind(&MediaSenderImpl::network_loop, this, shared_from_this()));
     encode_ctx_->spawn(std::bind(&MediaSenderImpl::capture_encode_loop, this, shared_from_this()));
     pacer_ctx_->spawn(std::bind(&MediaSenderImpl::pacing_loop, this, shared_from_this()));
+    pacer_ctx_->spawn(std::bind(&MediaSenderImpl::pacer_process_loop, this, shared_from_this()));
 }
 
 void MediaSenderImpl::stop()
@@ -43,6 +63,16 @@ void MediaSenderImpl::stop()
     stop_ = true;
 }
 
+Pacer::Stats MediaSenderImpl::pacer_stats() const
+{
+    return pacer_.stats(MachineNowMicroseconds());
+}
+
+BufferPool::Stats MediaSenderImpl::packet_buffer_stats() const
+{
+    return packet_buffers_.stats();
+}
+
 bco::Routine MediaSenderImpl::network_loop(std::shared_ptr<MediaSenderImpl> that)
 {
     while (!stop_) {
@@ -75,23 +105,28 @@ bco::Routine MediaSenderImpl::pacing_loop(std::shared_ptr<MediaSenderImpl> that)
 {
     while (!stop_) {
         auto frame = co_await receive_from_encode_loop();
+        // Picks up whatever the path MTU probing confirmed so far, never
+        // less than kMinDatagramSize so the header reserve always fits.
         Packetizer::PayloadSizeLimits limits;
+        limits.max_payload_len = static_cast<int>(transport_->max_datagram_size() - kRtpHeaderReserve);
         std::unique_ptr<Packetizer> packetizer = Packetizer::create(frame, VideoCodecType::H264, limits);
-        RtpPacket packet;
-        while (packetizer->has_next_packet()) {
-            RtpPacket packet;
-            packet.set_ssrc(kDefaultSsrc);
-            packet.set_payload_type(kDefaultPayloadType);
-            packet.set_timestamp(frame.timestamp + start_timestamp_);
-            packet.set_sequence_number(seq_number_++);
-            //first packet of frame
-            //allow retransmission
-            //is key frame
-            //packet type
-            add_required_rtp_extensions(packet);
-            packetizer->next_packet(packet);
-            transport_->send_rtp(packet);
-        }
+        // Headers for the whole frame first, then all payloads in one call.
+        prepare_frame_packets(frame, packetizer->num_packets());
+        const size_t count = packetizer->next_packets(frame_packets_);
+        pacer_.enqueue(std::span { frame_packets_ }.first(count), Pacer::Priority::kVideo);
+        frame_packets_.clear();
+        last_timestamp_ = frame.timestamp + start_timestamp_;
+        // Let the first burst of the frame out right away instead of waiting
+        // for the next tick of pacer_process_loop.
+        pacer_.process(MachineNowMicroseconds());
+    }
+}
+
+bco::Routine MediaSenderImpl::pacer_process_loop(std::shared_ptr<MediaSenderImpl> that)
+{
+    while (!stop_) {
+        auto next_process = pacer_.process(MachineNowMicroseconds());
+        co_await bco::sleep_for(next_process);
     }
 }
 
@@ -135,21 +170,53 @@ void MediaSenderImpl::encode_failed()
 
 void MediaSenderImpl::send_to_pacing_loop(Frame frame)
 {
-    encoded_frames_.send(frame);
+    encoded_frames_.push(std::move(frame));
 }
 
 inline bco::Task<Frame> MediaSenderImpl::receive_from_encode_loop()
 {
-    return encoded_frames_.recv();
+    return encoded_frames_.pop();
 }
 
-void MediaSenderImpl::add_required_rtp_extensions(RtpPacket& packet)
+void MediaSenderImpl::prepare_frame_packets(const Frame& frame, size_t count)
+{
+    const uint32_t timestamp = frame.timestamp + start_timestamp_;
+    // Encoded frames do not come with generic frame info yet.
+    RTPVideoHeader video_header {};
+    frame_packets_.clear();
+    frame_packets_.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const RtpGenericFrameDescriptor descriptor = make_frame_descriptor(video_header, i == 0, i + 1 == count);
+        const RtpHeaderTemplate& header_template = header_template_for(descriptor);
+        RtpPacket& packet = frame_packets_.emplace_back(header_template.create(packet_buffers_, seq_number_++, timestamp));
+        //allow retransmission
+        //is key frame
+        //packet type
+        header_template.write_extension<RtpGenericFrameDescriptorExtension00>(packet, descriptor);
+    }
+}
+
+const RtpHeaderTemplate& MediaSenderImpl::header_template_for(const RtpGenericFrameDescriptor& descriptor)
+{
+    // The descriptor is 1 byte in all but the first packet of a frame, so
+    // this is a handful of templates at most.
+    const uint8_t size = RtpGenericFrameDescriptorExtension00::value_size(descriptor);
+    for (const auto& header_template : header_templates_) {
+        if (header_template.extension_size(RtpGenericFrameDescriptorExtension00::id()) == size) {
+            return header_template;
+        }
+    }
+    RtpHeaderTemplate& header_template = header_templates_.emplace_back(kDefaultSsrc, kDefaultPayloadType);
+    header_template.add_extension<RtpGenericFrameDescriptorExtension00>(size);
+    return header_template;
+}
+
+RtpGenericFrameDescriptor MediaSenderImpl::make_frame_descriptor(const RTPVideoHeader& video_header, bool first_packet, bool last_packet)
 {
-    auto& video_header = packet.video_header<RTPVideoHeader>();
     RtpGenericFrameDescriptor descriptor;
-    descriptor.SetFirstPacketInSubFrame(false); //first packet
-    descriptor.SetLastPacketInSubFrame(false); //last packet
-    if (false) { //first packet
+    descriptor.SetFirstPacketInSubFrame(first_packet);
+    descriptor.SetLastPacketInSubFrame(last_packet);
+    if (first_packet && video_header.generic) {
         descriptor.SetFrameId(static_cast<uint16_t>(video_header.generic->frame_id));
         for (int64_t dep : video_header.generic->dependencies) {
             descriptor.AddFrameDependencyDiff(video_header.generic->frame_id - dep);
@@ -164,7 +231,20 @@ void MediaSenderImpl::add_required_rtp_extensions(RtpPacket& packet)
             descriptor.SetResolution(video_header.width, video_header.height);
         }
     }
-    packet.set_extension<RtpGenericFrameDescriptorExtension00>(descriptor);
+    return descriptor;
+}
+
+std::vector<RtpPacket> MediaSenderImpl::create_padding_packets(size_t bytes)
+{
+    std::vector<RtpPacket> packets;
+    while (bytes > 0) {
+        const size_t padding_size = std::min(bytes, kMaxPaddingSize);
+        RtpPacket packet = padding_template_.create(packet_buffers_, seq_number_++, last_timestamp_);
+        packet.set_padding(static_cast<uint8_t>(padding_size));
+        bytes -= padding_size;
+        packets.push_back(std::move(packet));
+    }
+    return packets;
 }
 
 
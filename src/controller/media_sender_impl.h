@@ -6,7 +6,10 @@
 #include <bco/coroutine/channel.h>
 #include <bco/net/proactor/select.h>
 #include <bco/context.h>
+#include "../common/spsc_ring.h"
 #include "../transport/transport.h"
+#include "../pacing/pacer.h"
+#include "../rtp/header_template.h"
 
 namespace brtc {
 
@@ -22,11 +25,14 @@ public:
         std::shared_ptr<bco::Context> pacer_ctx);
     void start();
     void stop();
+    Pacer::Stats pacer_stats() const;
+    BufferPool::Stats packet_buffer_stats() const;
 
 private:
     bco::Routine network_loop(std::shared_ptr<MediaSenderImpl> that);
     bco::Routine capture_encode_loop(std::shared_ptr<MediaSenderImpl> that);
     bco::Routine pacing_loop(std::shared_ptr<MediaSenderImpl> that);
+    bco::Routine pacer_process_loop(std::shared_ptr<MediaSenderImpl> that);
 
     Frame capture_one_frame();
     Frame encode_one_frame(Frame frame);
@@ -39,7 +45,10 @@ private:
     inline void send_to_pacing_loop(Frame frame);
     inline bco::Task<Frame> receive_from_encode_loop();
 
-    void add_required_rtp_extensions(RtpPacket& packet);
+    void prepare_frame_packets(const Frame& frame, size_t count);
+    const RtpHeaderTemplate& header_template_for(const RtpGenericFrameDescriptor& descriptor);
+    static RtpGenericFrameDescriptor make_frame_descriptor(const RTPVideoHeader& video_header, bool first_packet, bool last_packet);
+    std::vector<RtpPacket> create_padding_packets(size_t bytes);
 
 private:
     std::atomic<bool> stop_ { true };
@@ -50,8 +59,17 @@ private:
     std::shared_ptr<bco::Context> network_ctx_;
     std::shared_ptr<bco::Context> encode_ctx_;
     std::shared_ptr<bco::Context> pacer_ctx_;
-    bco::Channel<Frame> encoded_frames_;
+    SpscRing<Frame> encoded_frames_;
+    // Outgoing packets are serialized in place into blocks from here.
+    BufferPool packet_buffers_;
+    // Packets of the frame being packetized, reused from frame to frame.
+    std::vector<RtpPacket> frame_packets_;
+    // Media packet headers, one per generic frame descriptor size.
+    std::vector<RtpHeaderTemplate> header_templates_;
+    RtpHeaderTemplate padding_template_;
+    Pacer pacer_;
     uint32_t start_timestamp_;
+    uint32_t last_timestamp_ = 0;
     uint16_t seq_number_;
 };
 
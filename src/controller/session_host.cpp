@@ -0,0 +1,51 @@
+#include <brtc/interface.h>
+#include "transport/session_host.h"
+
+namespace brtc {
+
+SessionHost::SessionHost(std::vector<Shard>&& shards, const PathMtuConfig& path_mtu)
+    : impl_ { std::make_shared<SessionHostImpl>(std::move(shards), path_mtu) }
+{
+}
+
+SessionHost::~SessionHost()
+{
+    impl_->stop();
+}
+
+bool SessionHost::enable_reuse_port(const AnyUdpSocket& socket)
+{
+    return brtc::enable_reuse_port(socket.fd());
+}
+
+size_t SessionHost::shard_count() const
+{
+    return impl_->shard_count();
+}
+
+size_t SessionHost::shard_of(const bco::net::Address& remote_addr) const
+{
+    return impl_->shard_of(remote_addr);
+}
+
+TransportInfo SessionHost::transport_info(const bco::net::Address& remote_addr) const
+{
+    return impl_->transport_info(remote_addr);
+}
+
+std::shared_ptr<bco::Context> SessionHost::context(const bco::net::Address& remote_addr) const
+{
+    return impl_->context(remote_addr);
+}
+
+void SessionHost::start()
+{
+    impl_->start();
+}
+
+void SessionHost::stop()
+{
+    impl_->stop();
+}
+
+} // namespace brtc
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include "common/time_utils.h"
+#include "pacing/pacer.h"
+
+namespace brtc {
+
+namespace {
+constexpr int64_t kBitsPerByte = 8;
+constexpr int64_t kMicrosPerSecond = 1'000'000;
+constexpr int64_t kQueueDelaySmoothing = 16;
+
+int64_t bytes_in(int64_t bitrate_bps, int64_t duration_us)
+{
+    return bitrate_bps * duration_us / (kBitsPerByte * kMicrosPerSecond);
+}
+
+} // namespace
+
+Pacer::Pacer(const Config& config, SendFunc send_func, PaddingFunc padding_func)
+    : config_(config)
+    , send_func_(send_func)
+    , padding_func_(padding_func)
+{
+}
+
+void Pacer::enqueue(RtpPacket packet, Priority priority)
+{
+    queued_bytes_ += packet.size();
+    queues_[static_cast<size_t>(priority)].push_back(QueuedPacket { std::move(packet), MachineNowMicroseconds() });
+    publish_stats();
+}
+
+void Pacer::enqueue(std::span<RtpPacket> packets, Priority priority)
+{
+    const int64_t now_us = MachineNowMicroseconds();
+    auto& queue = queues_[static_cast<size_t>(priority)];
+    for (auto& packet : packets) {
+        queued_bytes_ += packet.size();
+        queue.push_back(QueuedPacket { std::move(packet), now_us });
+    }
+    publish_stats();
+}
+
+void Pacer::set_pacing_rate(int64_t bitrate_bps)
+{
+    config_.pacing_rate_bps = bitrate_bps;
+}
+
+void Pacer::set_padding_rate(int64_t bitrate_bps)
+{
+    padding_rate_bps_ = bitrate_bps;
+}
+
+void Pacer::create_probe(int64_t bitrate_bps, size_t bytes)
+{
+    probe_rate_bps_ = bitrate_bps;
+    probe_bytes_left_ = static_cast<int64_t>(bytes);
+}
+
+std::chrono::milliseconds Pacer::process(int64_t now_us)
+{
+    const int64_t burst_window_us = std::chrono::duration_cast<std::chrono::microseconds>(config_.burst_window).count();
+    const int64_t elapsed_us = last_process_us_ < 0 ? burst_window_us : now_us - last_process_us_;
+    last_process_us_ = now_us;
+
+    const int64_t rate_bps = effective_rate_bps();
+    media_budget_ = std::min(media_budget_ + bytes_in(rate_bps, elapsed_us), bytes_in(rate_bps, burst_window_us));
+    padding_budget_ = std::min(padding_budget_ + bytes_in(padding_rate_bps_, elapsed_us), bytes_in(padding_rate_bps_, burst_window_us));
+
+    batch_.clear();
+    batch_bytes_ = 0;
+    while (!queue_empty() && media_budget_ > 0) {
+        QueuedPacket queued = pop_next();
+        const int64_t delay_us = std::max<int64_t>(0, now_us - queued.enqueue_time_us);
+        stats_.max_queue_delay_us = std::max(stats_.max_queue_delay_us, delay_us);
+        stats_.avg_queue_delay_us += (delay_us - stats_.avg_queue_delay_us) / kQueueDelaySmoothing;
+        const int64_t size = static_cast<int64_t>(queued.packet.size());
+        media_budget_ -= size;
+        // Media counts towards the padding rate, but a large frame must not
+        // hold padding back for longer than it took to send.
+        padding_budget_ = std::max<int64_t>(0, padding_budget_ - size);
+        probe_bytes_left_ -= std::min(probe_bytes_left_, size);
+        batch_bytes_ += size;
+        batch_.push_back(std::move(queued.packet));
+    }
+    if (queue_empty() && media_budget_ > 0) {
+        if (probe_bytes_left_ > 0) {
+            send_padding(static_cast<size_t>(std::min(media_budget_, probe_bytes_left_)));
+        } else if (padding_budget_ > 0) {
+            send_padding(static_cast<size_t>(std::min(media_budget_, padding_budget_)));
+        }
+    }
+    if (probe_bytes_left_ == 0) {
+        probe_rate_bps_ = 0;
+    }
+    if (!batch_.empty()) {
+        send_func_(batch_);
+    }
+    update_burst_stats();
+    publish_stats();
+
+    if (media_budget_ > 0 || rate_bps <= 0) {
+        return config_.max_idle_interval;
+    }
+    // In debt, come back once the budget turns positive again.
+    const int64_t wait_us = -media_budget_ * kBitsPerByte * kMicrosPerSecond / rate_bps;
+    auto wait = std::chrono::milliseconds { (wait_us + 999) / 1000 };
+    return std::clamp(wait, std::chrono::milliseconds { 1 }, config_.max_idle_interval);
+}
+
+Pacer::Stats Pacer::stats(int64_t now_us) const
+{
+    Stats stats;
+    stats.queued_packets = published_.queued_packets.load(std::memory_order_relaxed);
+    stats.queued_bytes = published_.queued_bytes.load(std::memory_order_relaxed);
+    const int64_t oldest_enqueue_time_us = published_.oldest_enqueue_time_us.load(std::memory_order_relaxed);
+    if (oldest_enqueue_time_us >= 0) {
+        stats.queue_delay_us = std::max<int64_t>(0, now_us - oldest_enqueue_time_us);
+    }
+    stats.avg_queue_delay_us = published_.avg_queue_delay_us.load(std::memory_order_relaxed);
+    stats.max_queue_delay_us = published_.max_queue_delay_us.load(std::memory_order_relaxed);
+    stats.last_burst_packets = published_.last_burst_packets.load(std::memory_order_relaxed);
+    stats.max_burst_packets = published_.max_burst_packets.load(std::memory_order_relaxed);
+    stats.max_burst_bytes = published_.max_burst_bytes.load(std::memory_order_relaxed);
+    stats.padding_bytes = published_.padding_bytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+int64_t Pacer::effective_rate_bps() const
+{
+    const int64_t max_queue_time_us = std::chrono::duration_cast<std::chrono::microseconds>(config_.max_queue_time).count();
+    int64_t drain_rate_bps = 0;
+    if (max_queue_time_us > 0) {
+        drain_rate_bps = static_cast<int64_t>(queued_bytes_) * kBitsPerByte * kMicrosPerSecond / max_queue_time_us;
+    }
+    return std::max({ config_.pacing_rate_bps, probe_rate_bps_, drain_rate_bps });
+}
+
+bool Pacer::queue_empty() const
+{
+    return std::all_of(queues_.begin(), queues_.end(), [](const auto& queue) { return queue.empty(); });
+}
+
+Pacer::QueuedPacket Pacer::pop_next()
+{
+    for (auto& queue : queues_) {
+        if (!queue.empty()) {
+            QueuedPacket queued = std::move(queue.front());
+            queue.pop_front();
+            queued_bytes_ -= queued.packet.size();
+            return queued;
+        }
+    }
+    return QueuedPacket { RtpPacket {}, 0 };
+}
+
+void Pacer::send_padding(size_t bytes)
+{
+    if (!padding_func_) {
+        return;
+    }
+    for (auto& packet : padding_func_(bytes)) {
+        const int64_t size = static_cast<int64_t>(packet.size());
+        stats_.padding_bytes += size;
+        media_budget_ -= size;
+        padding_budget_ -= size;
+        probe_bytes_left_ -= std::min(probe_bytes_left_, size);
+        batch_bytes_ += size;
+        batch_.push_back(std::move(packet));
+    }
+}
+
+void Pacer::update_burst_stats()
+{
+    stats_.last_burst_packets = batch_.size();
+    stats_.max_burst_packets = std::max(stats_.max_burst_packets, batch_.size());
+    stats_.max_burst_bytes = std::max(stats_.max_burst_bytes, batch_bytes_);
+}
+
+void Pacer::publish_stats()
+{
+    size_t queued_packets = 0;
+    int64_t oldest_enqueue_time_us = -1;
+    for (const auto& queue : queues_) {
+        queued_packets += queue.size();
+        if (!queue.empty() && (oldest_enqueue_time_us < 0 || queue.front().enqueue_time_us < oldest_enqueue_time_us)) {
+            oldest_enqueue_time_us = queue.front().enqueue_time_us;
+        }
+    }
+    published_.queued_packets.store(queued_packets, std::memory_order_relaxed);
+    published_.queued_bytes.store(queued_bytes_, std::memory_order_relaxed);
+    published_.oldest_enqueue_time_us.store(oldest_enqueue_time_us, std::memory_order_relaxed);
+    published_.avg_queue_delay_us.store(stats_.avg_queue_delay_us, std::memory_order_relaxed);
+    published_.max_queue_delay_us.store(stats_.max_queue_delay_us, std::memory_order_relaxed);
+    published_.last_burst_packets.store(stats_.last_burst_packets, std::memory_order_relaxed);
+    published_.max_burst_packets.store(stats_.max_burst_packets, std::memory_order_relaxed);
+    published_.max_burst_bytes.store(stats_.max_burst_bytes, std::memory_order_relaxed);
+    published_.padding_bytes.store(stats_.padding_bytes, std::memory_order_relaxed);
+}
+
+} // namespace brtc
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <span>
+#include <vector>
+#include "rtp/rtp.h"
+
+namespace brtc {
+
+// Leaky bucket pacer. Packets are queued by priority and released in batches
+// whenever process() finds budget for them, the budget refills at the pacing
+// rate and is capped so that at most |burst_window| worth of data leaves at
+// once. Not thread safe, enqueue() and process() must run on the same context,
+// only stats() may be called from anywhere.
+class Pacer {
+public:
+    // Lower value goes first.
+    enum class Priority : uint8_t {
+        kAudio,
+        kRetransmission,
+        kVideo,
+        kPadding,
+    };
+
+    struct Config {
+        int64_t pacing_rate_bps = 10'000'000;
+        // Raise the rate when needed so that the queue drains within this time,
+        // typically one frame interval, a keyframe is spread over it instead
+        // of building latency.
+        std::chrono::milliseconds max_queue_time { 16 };
+        std::chrono::milliseconds burst_window { 5 };
+        std::chrono::milliseconds max_idle_interval { 5 };
+    };
+
+    struct Stats {
+        size_t queued_packets = 0;
+        size_t queued_bytes = 0;
+        // Age of the oldest packet still in the queue.
+        int64_t queue_delay_us = 0;
+        int64_t avg_queue_delay_us = 0;
+        int64_t max_queue_delay_us = 0;
+        size_t last_burst_packets = 0;
+        size_t max_burst_packets = 0;
+        size_t max_burst_bytes = 0;
+        uint64_t padding_bytes = 0;
+    };
+
+    using SendFunc = std::function<void(std::span<const RtpPacket>)>;
+    // Returns padding packets carrying about |bytes| bytes in total.
+    using PaddingFunc = std::function<std::vector<RtpPacket>(size_t bytes)>;
+
+public:
+    Pacer(const Config& config, SendFunc send_func, PaddingFunc padding_func);
+
+    void enqueue(RtpPacket packet, Priority priority);
+    // Moves every packet of |packets| in, e.g. all packets of a frame.
+    void enqueue(std::span<RtpPacket> packets, Priority priority);
+    void set_pacing_rate(int64_t bitrate_bps);
+    void set_padding_rate(int64_t bitrate_bps);
+    // Sends |bytes| at |bitrate_bps| regardless of the pacing rate, topping up
+    // with padding when there is not enough media queued.
+    void create_probe(int64_t bitrate_bps, size_t bytes);
+
+    // Sends whatever the budget allows at |now_us| (MachineNowMicroseconds()),
+    // returns how long to wait before calling again.
+    std::chrono::milliseconds process(int64_t now_us);
+    // As of the last enqueue() or process(), each field on its own.
+    Stats stats(int64_t now_us) const;
+
+private:
+    struct QueuedPacket {
+        RtpPacket packet;
+        int64_t enqueue_time_us;
+    };
+
+    int64_t effective_rate_bps() const;
+    bool queue_empty() const;
+    QueuedPacket pop_next();
+    void send_padding(size_t bytes);
+    void update_burst_stats();
+    void publish_stats();
+
+private:
+    Config config_;
+    SendFunc send_func_;
+    PaddingFunc padding_func_;
+    std::array<std::deque<QueuedPacket>, 4> queues_;
+    size_t queued_bytes_ = 0;
+    int64_t padding_rate_bps_ = 0;
+    int64_t probe_rate_bps_ = 0;
+    int64_t probe_bytes_left_ = 0;
+    // Bytes that may still be sent, negative while in debt.
+    int64_t media_budget_ = 0;
+    int64_t padding_budget_ = 0;
+    int64_t last_process_us_ = -1;
+    std::vector<RtpPacket> batch_;
+    size_t batch_bytes_ = 0;
+    Stats stats_;
+
+    // What stats() reads, the queues and |stats_| belong to the pacing context.
+    struct PublishedStats {
+        std::atomic<size_t> queued_packets { 0 };
+        std::atomic<size_t> queued_bytes { 0 };
+        // -1 while nothing is queued.
+        std::atomic<int64_t> oldest_enqueue_time_us { -1 };
+        std::atomic<int64_t> avg_queue_delay_us { 0 };
+        std::atomic<int64_t> max_queue_delay_us { 0 };
+        std::atomic<size_t> last_burst_packets { 0 };
+        std::atomic<size_t> max_burst_packets { 0 };
+        std::atomic<size_t> max_burst_bytes { 0 };
+        std::atomic<uint64_t> padding_bytes { 0 };
+    };
+    PublishedStats published_;
+};
+
+} // namespace brtc
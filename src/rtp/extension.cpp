@@ -136,11 +136,6 @@ bool RtpGenericFrameDescriptor::AddFrameDependencyDiff(uint16_t fdiff)
     return true;
 }
 
-const RTPExtensionType RtpGenericFrameDescriptorExtension00::id()
-{
-    return RTPExtensionType::kRtpExtensionGenericFrameDescriptor00;
-}
-
 const char* RtpGenericFrameDescriptorExtension00::uri()
 {
     return "http://www.webrtc.org/experiments/rtp-hdrext/"
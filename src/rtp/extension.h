@@ -110,7 +110,7 @@ class RtpGenericFrameDescriptorExtension00 {
 public:
     using value_type = RtpGenericFrameDescriptor;
 
-    static const RTPExtensionType id();
+    static constexpr RTPExtensionType id() { return RTPExtensionType::kRtpExtensionGenericFrameDescriptor00; }
 
     static const char* uri();
 
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include "rtp/extension_map.h"
+
+namespace brtc {
+
+namespace {
+
+template <typename... Extensions>
+RTPExtensionType type_from_uri(std::string_view uri)
+{
+    RTPExtensionType type = RTPExtensionType::kRtpExtensionNone;
+    ((uri == Extensions::uri() ? (type = Extensions::id(), true) : false) || ...);
+    return type;
+}
+
+} // namespace
+
+RtpHeaderExtensionMap::RtpHeaderExtensionMap()
+{
+    for (size_t type = 1; type < kNumTypes; type++) {
+        register_extension(static_cast<RTPExtensionType>(type), static_cast<uint8_t>(type));
+    }
+}
+
+RtpHeaderExtensionMap RtpHeaderExtensionMap::empty()
+{
+    RtpHeaderExtensionMap map;
+    map.clear();
+    return map;
+}
+
+const RtpHeaderExtensionMap& RtpHeaderExtensionMap::default_map()
+{
+    static const RtpHeaderExtensionMap kDefaultMap;
+    return kDefaultMap;
+}
+
+bool RtpHeaderExtensionMap::register_extension(RTPExtensionType type, uint8_t id)
+{
+    const size_t slot = static_cast<size_t>(type);
+    if (id == kInvalidId || slot == 0 || slot >= kNumTypes) {
+        return false;
+    }
+    if (types_[id] != 0 && types_[id] != slot) {
+        return false;
+    }
+    // Re-registering a type moves it to the new id.
+    if (ids_[slot] != kInvalidId) {
+        types_[ids_[slot]] = 0;
+    }
+    types_[id] = static_cast<uint8_t>(slot);
+    ids_[slot] = id;
+    update_max_id();
+    return true;
+}
+
+bool RtpHeaderExtensionMap::register_by_uri(std::string_view uri, uint8_t id)
+{
+    const RTPExtensionType type = type_from_uri<RtpGenericFrameDescriptorExtension00>(uri);
+    if (type == RTPExtensionType::kRtpExtensionNone) {
+        return false;
+    }
+    return register_extension(type, id);
+}
+
+void RtpHeaderExtensionMap::deregister(RTPExtensionType type)
+{
+    const size_t slot = static_cast<size_t>(type);
+    if (slot >= kNumTypes || ids_[slot] == kInvalidId) {
+        return;
+    }
+    types_[ids_[slot]] = 0;
+    ids_[slot] = kInvalidId;
+    update_max_id();
+}
+
+void RtpHeaderExtensionMap::clear()
+{
+    types_.fill(0);
+    ids_.fill(kInvalidId);
+    max_id_ = 0;
+}
+
+void RtpHeaderExtensionMap::update_max_id()
+{
+    max_id_ = *std::max_element(ids_.begin(), ids_.end());
+}
+
+} // namespace brtc
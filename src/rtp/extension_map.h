@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <string_view>
+#include "rtp/extension.h"
+
+namespace brtc {
+
+// Negotiated mapping between RTP header extension wire ids (1-255) and
+// RTPExtensionType. Both directions are flat arrays, so resolving an id while
+// parsing or a type while building a packet is a single load.
+// A default constructed map registers every type under its enum value, which
+// is what both ends used before ids were negotiated.
+class RtpHeaderExtensionMap {
+public:
+    static constexpr uint8_t kInvalidId = 0;
+    static constexpr uint8_t kMaxId = 255;
+    static constexpr size_t kNumTypes = static_cast<size_t>(RTPExtensionType::kRtpExtensionNumberOfExtensions);
+
+public:
+    RtpHeaderExtensionMap();
+    // An empty map, extensions have to be registered one by one.
+    static RtpHeaderExtensionMap empty();
+    // The map packets fall back to when none is given.
+    static const RtpHeaderExtensionMap& default_map();
+
+    // Fails if |id| is out of range or already taken by another type.
+    bool register_extension(RTPExtensionType type, uint8_t id);
+    template <typename T> requires RtpExtension<T>
+    bool register_extension(uint8_t id) { return register_extension(T::id(), id); }
+    // For ids coming from a=extmap lines, unknown uris are ignored.
+    bool register_by_uri(std::string_view uri, uint8_t id);
+    void deregister(RTPExtensionType type);
+    void clear();
+
+    RTPExtensionType type(uint8_t id) const
+    {
+        return static_cast<RTPExtensionType>(types_[id]);
+    }
+    uint8_t id(RTPExtensionType type) const
+    {
+        return ids_[static_cast<size_t>(type)];
+    }
+    template <typename T> requires RtpExtension<T>
+    uint8_t id() const
+    {
+        constexpr size_t kSlot = static_cast<size_t>(T::id());
+        static_assert(kSlot < kNumTypes);
+        return ids_[kSlot];
+    }
+    bool is_registered(RTPExtensionType type) const { return id(type) != kInvalidId; }
+    // Highest registered id, anything above 14 needs the two-byte header form.
+    uint8_t max_id() const { return max_id_; }
+
+private:
+    void update_max_id();
+
+private:
+    std::array<uint8_t, kMaxId + 1> types_ {};
+    std::array<uint8_t, kNumTypes> ids_ {};
+    uint8_t max_id_ = 0;
+};
+
+} // namespace brtc
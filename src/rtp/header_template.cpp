@@ -0,0 +1,131 @@
+#include <cstring>
+#include "rtp/header_template.h"
+
+namespace brtc {
+
+namespace {
+constexpr size_t kFixedHeaderSize = 12;
+constexpr uint8_t kRtpVersion = 2;
+constexpr size_t kSequenceNumberOffset = 2;
+constexpr size_t kTimestampOffset = 4;
+constexpr size_t kSsrcOffset = 8;
+
+void write_big_endian(uint8_t* data, uint16_t value)
+{
+    data[0] = static_cast<uint8_t>(value >> 8);
+    data[1] = static_cast<uint8_t>(value);
+}
+
+void write_big_endian(uint8_t* data, uint32_t value)
+{
+    data[0] = static_cast<uint8_t>(value >> 24);
+    data[1] = static_cast<uint8_t>(value >> 16);
+    data[2] = static_cast<uint8_t>(value >> 8);
+    data[3] = static_cast<uint8_t>(value);
+}
+
+} // namespace
+
+RtpHeaderTemplate::RtpHeaderTemplate(uint32_t ssrc, uint8_t payload_type, const RtpHeaderExtensionMap* extension_map)
+    : ssrc_(ssrc)
+    , payload_type_(payload_type & 0b0111'1111)
+    , extension_map_(extension_map ? extension_map : &RtpHeaderExtensionMap::default_map())
+{
+    encode();
+}
+
+bool RtpHeaderTemplate::add_extension(RTPExtensionType type, uint8_t value_size)
+{
+    if (value_size == 0 || !extension_map_->is_registered(type) || extension_size(type) != 0) {
+        return false;
+    }
+    slots_.push_back(Slot { type, value_size });
+    encode();
+    return true;
+}
+
+uint8_t RtpHeaderTemplate::extension_size(RTPExtensionType type) const
+{
+    for (const auto& slot : slots_) {
+        if (slot.type == type) {
+            return slot.value_size;
+        }
+    }
+    return 0;
+}
+
+RtpPacket RtpHeaderTemplate::create(BufferPool& pool, uint16_t sequence_number, uint32_t timestamp) const
+{
+    auto [block, lease] = pool.acquire();
+    RtpPacket packet { extension_map_, block, std::move(lease) };
+    const size_t size = image_.size();
+    if (size <= packet.block_.size()) {
+        uint8_t* data = packet.block_.data();
+        ::memcpy(data, image_.data(), size);
+        write_big_endian(data + kSequenceNumberOffset, sequence_number);
+        write_big_endian(data + kTimestampOffset, timestamp);
+    } else {
+        // Blocks are MTU sized, this only happens with a misconfigured pool.
+        packet.leave_block();
+        packet.buffer_ = bco::Buffer {};
+        packet.buffer_.push_back(std::vector<uint8_t>(image_), true);
+        packet.buffer_.write_big_endian_at(kSequenceNumberOffset, sequence_number);
+        packet.buffer_.write_big_endian_at(kTimestampOffset, timestamp);
+    }
+    packet.header_ = header_;
+    packet.header_.sequence_number = sequence_number;
+    packet.header_.timestamp = timestamp;
+    packet.extension_mode_ = extension_mode_;
+    packet.extension_entries_ = extension_entries_;
+    packet.extension_index_ = extension_index_;
+    return packet;
+}
+
+void RtpHeaderTemplate::encode()
+{
+    image_.assign(kFixedHeaderSize, 0);
+    image_[0] = kRtpVersion << 6;
+    image_[1] = payload_type_;
+    write_big_endian(&image_[kSsrcOffset], ssrc_);
+    header_ = RtpPacket::Header {};
+    header_.ssrc = ssrc_;
+    header_.payload_type = payload_type_;
+    extension_entries_.clear();
+    extension_index_.fill(0);
+    if (!slots_.empty()) {
+        // Same choice as RtpPacket makes while building, two-byte elements
+        // only when an id or a value does not fit the one-byte form.
+        extension_mode_ = extension_map_->max_id() > kOneByteHeaderExtensionMaxId
+            ? RtpPacket::ExtensionMode::kTwoByte
+            : RtpPacket::ExtensionMode::kOneByte;
+        for (const auto& slot : slots_) {
+            if (slot.value_size > kOneByteHeaderExtensionMaxValueSize) {
+                extension_mode_ = RtpPacket::ExtensionMode::kTwoByte;
+            }
+        }
+        const bool one_byte = extension_mode_ == RtpPacket::ExtensionMode::kOneByte;
+        image_[0] |= 0b0001'0000;
+        image_.resize(kFixedHeaderSize + 4, 0);
+        write_big_endian(&image_[kFixedHeaderSize], static_cast<uint16_t>(one_byte ? 0xBEDE : 0x1000));
+        for (const auto& slot : slots_) {
+            const uint8_t id = extension_map_->id(slot.type);
+            if (one_byte) {
+                image_.push_back(static_cast<uint8_t>(id << 4 | (slot.value_size - 1)));
+            } else {
+                image_.push_back(id);
+                image_.push_back(slot.value_size);
+            }
+            extension_entries_.push_back(RtpPacket::ExtensionInfo { slot.type, static_cast<uint16_t>(image_.size()), slot.value_size });
+            extension_index_[static_cast<size_t>(slot.type)] = static_cast<uint8_t>(extension_entries_.size());
+            image_.resize(image_.size() + slot.value_size, 0);
+        }
+        image_.resize((image_.size() + 3) / 4 * 4, 0);
+        const size_t extensions_size = image_.size() - kFixedHeaderSize - 4;
+        write_big_endian(&image_[kFixedHeaderSize + 2], static_cast<uint16_t>(extensions_size / 4));
+        header_.extensions_size = static_cast<uint16_t>(extensions_size);
+    }
+    header_.headers_size = static_cast<uint16_t>(image_.size());
+    header_.size = static_cast<uint16_t>(image_.size());
+}
+
+} // namespace brtc
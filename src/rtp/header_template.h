@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "common/buffer_pool.h"
+#include "rtp/extension_map.h"
+#include "rtp/rtp.h"
+
+namespace brtc {
+
+// The header of one outgoing stream, encoded once: V/P/X/CC, payload type,
+// SSRC and the extension block with a fixed size slot per extension. Packets
+// created from it start as a copy of those bytes, only the sequence number,
+// timestamp, marker and extension values are written per packet, each at an
+// offset known up front.
+class RtpHeaderTemplate {
+public:
+    // |extension_map| must outlive the template and its packets, null means
+    // RtpHeaderExtensionMap::default_map().
+    RtpHeaderTemplate(uint32_t ssrc, uint8_t payload_type, const RtpHeaderExtensionMap* extension_map = nullptr);
+
+    // Reserves |value_size| bytes for |type|, fails if it is not registered
+    // or already has a slot.
+    bool add_extension(RTPExtensionType type, uint8_t value_size);
+    template <typename T> requires RtpExtension<T>
+    bool add_extension(uint8_t value_size) { return add_extension(T::id(), value_size); }
+    // Slot size of |type|, 0 if it has none.
+    uint8_t extension_size(RTPExtensionType type) const;
+
+    // A packet serialized in place into a block from |pool| with the whole
+    // header already written, the payload goes right after it.
+    RtpPacket create(BufferPool& pool, uint16_t sequence_number, uint32_t timestamp) const;
+    // Writes |value| into its slot of |packet|, which must come from create().
+    // Fails if |value| does not encode to exactly the slot size.
+    template <typename T> requires RtpExtension<T>
+    bool write_extension(RtpPacket& packet, const typename T::value_type& value) const;
+
+    size_t headers_size() const { return image_.size(); }
+
+private:
+    void encode();
+
+private:
+    struct Slot {
+        RTPExtensionType type;
+        uint8_t value_size;
+    };
+
+    uint32_t ssrc_;
+    uint8_t payload_type_;
+    const RtpHeaderExtensionMap* extension_map_;
+    std::vector<Slot> slots_;
+    // Everything below is derived from the fields above by encode().
+    std::vector<uint8_t> image_;
+    RtpPacket::Header header_;
+    RtpPacket::ExtensionMode extension_mode_ = RtpPacket::ExtensionMode::kOneByte;
+    SmallVector<RtpPacket::ExtensionInfo, kInlineExtensionsPerPacket> extension_entries_;
+    std::array<uint8_t, RtpHeaderExtensionMap::kNumTypes> extension_index_ {};
+};
+
+template <typename T> requires RtpExtension<T>
+inline bool RtpHeaderTemplate::write_extension(RtpPacket& packet, const typename T::value_type& value) const
+{
+    const uint8_t index = packet.extension_index_[static_cast<size_t>(T::id())];
+    if (index == 0) {
+        return false;
+    }
+    const RtpPacket::ExtensionInfo& entry = packet.extension_entries_[index - 1];
+    if (T::value_size(value) != entry.length) {
+        return false;
+    }
+    return T::write_to_buff(packet.buffer_.subbuf(entry.offset, entry.length), value);
+}
+
+} // namespace brtc
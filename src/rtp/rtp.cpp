@@ -1,3 +1,4 @@
+#include <cstring>
 #include "rtp.h"
 
 namespace {
@@ -52,21 +53,148 @@ namespace brtc {
 // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
 RtpPacket::RtpPacket()
-    : buffer_(kFixedHeaderSize)
+    : RtpPacket(nullptr)
 {
+}
+
+RtpPacket::RtpPacket(const RtpHeaderExtensionMap* extension_map)
+    : RtpPacket(extension_map, bco::Buffer { kFixedHeaderSize }, BufferPool::Lease {})
+{
+    leave_block();
+}
+
+RtpPacket::RtpPacket(const RtpHeaderExtensionMap* extension_map, bco::Buffer block, BufferPool::Lease lease)
+    : extension_map_(extension_map ? extension_map : &RtpHeaderExtensionMap::default_map())
+    , buffer_(block)
+    , block_(block.data().front())
+    , lease_(std::move(lease))
+{
+    // Start in the form the registered ids need, so that adding extensions
+    // never has to move the ones already written.
+    if (extension_map_->max_id() > kOneByteHeaderExtensionMaxId) {
+        extension_mode_ = ExtensionMode::kTwoByte;
+    }
+    append_n_bytes(kFixedHeaderSize);
     buffer_[0] = kRtpVersion << 6;
+    header_.headers_size = kFixedHeaderSize;
+}
+
+RtpPacket RtpPacket::create(BufferPool& pool, const RtpHeaderExtensionMap* extension_map)
+{
+    auto [block, lease] = pool.acquire();
+    return RtpPacket { extension_map, block, std::move(lease) };
+}
+
+RtpPacket::RtpPacket(bco::Buffer buff, BufferPool::Lease lease, const RtpHeaderExtensionMap* extension_map)
+    : RtpPacket(buff, extension_map)
+{
+    lease_ = std::move(lease);
+}
+
+RtpPacket::RtpPacket(const RtpPacket& other)
+    : header_(other.header_)
+    , extension_map_(other.extension_map_)
+    , extension_mode_(other.extension_mode_)
+    , extension_entries_(other.extension_entries_)
+    , extension_index_(other.extension_index_)
+    , video_header_(other.video_header_ ? std::make_unique<VideoHeader>(*other.video_header_) : nullptr)
+    , buffer_(other.buffer_)
+    , lease_(other.lease_)
+    , payload_owner_(other.payload_owner_)
+{
+    // The block stays with |other|, appending to both would overwrite each
+    // other's bytes.
+    leave_block();
+}
+
+RtpPacket& RtpPacket::operator=(const RtpPacket& other)
+{
+    if (this != &other) {
+        header_ = other.header_;
+        extension_map_ = other.extension_map_;
+        extension_mode_ = other.extension_mode_;
+        extension_entries_ = other.extension_entries_;
+        extension_index_ = other.extension_index_;
+        video_header_ = other.video_header_ ? std::make_unique<VideoHeader>(*other.video_header_) : nullptr;
+        buffer_ = other.buffer_;
+        lease_ = other.lease_;
+        payload_owner_ = other.payload_owner_;
+        leave_block();
+    }
+    return *this;
+}
+
+RtpPacket::RtpPacket(const RtpPacket& other, bco::Buffer buffer)
+    : header_(other.header_)
+    , extension_map_(other.extension_map_)
+    , extension_mode_(other.extension_mode_)
+    , extension_entries_(other.extension_entries_)
+    , extension_index_(other.extension_index_)
+    , buffer_(buffer)
+    , lease_(other.lease_)
+    , payload_owner_(other.payload_owner_)
+{
+}
+
+RtpPacket RtpPacket::share_payload() const
+{
+    const size_t headers_size = header_.headers_size;
+    bco::Buffer buffer { headers_size };
+    uint8_t* header = buffer.data().front().data();
+    for (auto span : buffer_.subbuf(0, headers_size).data()) {
+        ::memcpy(header, span.data(), span.size());
+        header += span.size();
+    }
+    // |lease_| and |payload_owner_| keep the shared spans alive.
+    for (auto span : buffer_.subbuf(headers_size, header_.size - headers_size).data()) {
+        buffer.push_back(span, true);
+    }
+    return RtpPacket { *this, buffer };
 }
 
-RtpPacket::RtpPacket(bco::Buffer buff)
-    : buffer_(buff)
+const RtpPacket::VideoHeader& RtpPacket::empty_video_header()
 {
-    const bool has_padding = (buffer_[0] & 0x20) != 0;
-    const bool has_extension = (buffer_[0] & 0x10) != 0;
-    const uint8_t number_of_crcs = buffer_[0] & 0x0f;
-    uint8_t padding_size = 0;
-    if (has_padding) {
-        padding_size = buffer_.data().back().back();
+    static const VideoHeader kEmptyVideoHeader;
+    return kEmptyVideoHeader;
+}
+
+RtpPacket::RtpPacket(bco::Buffer buff, const RtpHeaderExtensionMap* extension_map)
+    : extension_map_(extension_map ? extension_map : &RtpHeaderExtensionMap::default_map())
+    , buffer_(buff)
+{
+    const size_t size = buffer_.size();
+    header_.size = static_cast<uint16_t>(size);
+    if (size < kFixedHeaderSize) {
+        header_.headers_size = static_cast<uint16_t>(size);
+        return;
+    }
+    const uint8_t first_byte = buffer_[0];
+    const bool has_padding = (first_byte & 0x20) != 0;
+    const bool has_extension = (first_byte & 0x10) != 0;
+    header_.csrcs_size = first_byte & 0x0f;
+    header_.marker = (buffer_[1] & 0b1000'0000) != 0;
+    header_.payload_type = buffer_[1] & 0b0111'1111;
+    buffer_.read_big_endian_at(2, header_.sequence_number);
+    buffer_.read_big_endian_at(4, header_.timestamp);
+    buffer_.read_big_endian_at(8, header_.ssrc);
+    size_t headers_size = kFixedHeaderSize + header_.csrcs_size * sizeof(uint32_t);
+    if (has_extension && headers_size + sizeof(uint32_t) <= size) {
+        uint16_t extension_words = 0;
+        buffer_.read_big_endian_at(headers_size + sizeof(uint16_t), extension_words);
+        header_.extensions_size = static_cast<uint16_t>(extension_words * sizeof(uint32_t));
+        headers_size += sizeof(uint32_t) + header_.extensions_size;
     }
+    if (has_padding && headers_size < size) {
+        header_.padding_size = buffer_[size - 1];
+    }
+    if (headers_size + header_.padding_size > size) {
+        // Truncated or malformed, leave it with an empty payload.
+        header_.headers_size = static_cast<uint16_t>(size);
+        header_.extensions_size = 0;
+        header_.padding_size = 0;
+        return;
+    }
+    header_.headers_size = static_cast<uint16_t>(headers_size);
     //ҪҪextension_entries_
     if (has_extension) {
         uint16_t magic;
@@ -83,9 +211,7 @@ RtpPacket::RtpPacket(bco::Buffer buff)
             return;
         }
         uint16_t number_of_extension = 0;
-        size_t extension_bytes;
-        buffer_.read_big_endian_at(kFixedHeaderSize + csrcs_size() * sizeof(uint32_t) + sizeof(uint16_t), extension_bytes);
-        extension_bytes *= sizeof(uint32_t);
+        const size_t extension_bytes = header_.extensions_size;
         size_t extension_offset = kFixedHeaderSize + csrcs_size() * sizeof(uint32_t) + sizeof(uint32_t);
         //extension_entries_
         constexpr uint8_t kPaddingByte = 0;
@@ -114,7 +240,13 @@ RtpPacket::RtpPacket(bco::Buffer buff)
                 break;
             }
 
-            ExtensionInfo& extension_info = find_or_create_extension_info(static_cast <RTPExtensionType>(id));
+            const RTPExtensionType type = extension_map_->type(static_cast<uint8_t>(id));
+            if (type == RTPExtensionType::kRtpExtensionNone) {
+                // Not negotiated, skip it.
+                number_of_extension += extension_header_length + length;
+                continue;
+            }
+            ExtensionInfo& extension_info = find_or_create_extension_info(type);
             if (extension_info.length != 0) {
                 //LOG(VERBOSE)
                 //    << "Duplicate rtp header extension id " << id << ". Overwriting.";
@@ -134,33 +266,27 @@ RtpPacket::RtpPacket(bco::Buffer buff)
 
 bool RtpPacket::marker() const
 {
-    return buffer_[1] & 0b1000'0000;
+    return header_.marker;
 }
 
 uint8_t RtpPacket::payload_type() const
 {
-    return buffer_[1] & 0b0111'1111;
+    return header_.payload_type;
 }
 
 uint16_t RtpPacket::sequence_number() const
 {
-    uint16_t seq = 0;
-    buffer_.read_big_endian_at(2, seq);
-    return seq;
+    return header_.sequence_number;
 }
 
 uint32_t RtpPacket::timestamp() const
 {
-    uint32_t t = 0;
-    buffer_.read_big_endian_at(4, t);
-    return t;
+    return header_.timestamp;
 }
 
 uint32_t RtpPacket::ssrc() const
 {
-    uint32_t s;
-    buffer_.read_big_endian_at(8, s);
-    return s;
+    return header_.ssrc;
 }
 
 std::vector<uint32_t> RtpPacket::csrcs() const
@@ -175,38 +301,27 @@ std::vector<uint32_t> RtpPacket::csrcs() const
 
 size_t RtpPacket::csrcs_size() const
 {
-    return buffer_[0] & 0x0F;
+    return header_.csrcs_size;
 }
 
 size_t RtpPacket::headers_size() const
 {
-    return kFixedHeaderSize + csrcs_size() * sizeof(uint32_t) + sizeof(uint32_t) + extensions_size();
+    return header_.headers_size;
 }
 
 size_t RtpPacket::payload_size() const
 {
-    return buffer_.size() - headers_size() - padding_size();
+    return header_.size - header_.headers_size - header_.padding_size;
 }
 
 size_t RtpPacket::padding_size() const
 {
-    size_t size = buffer_.size();
-    return buffer_[size - 1];
+    return header_.padding_size;
 }
 
 size_t RtpPacket::extensions_size() const
 {
-    size_t size = 0;
-    if (extension_mode_ == ExtensionMode::kOneByte) {
-        for (const auto& entry : extension_entries_) {
-            size += (entry.length + 2) * 8;
-        }
-    } else {
-        for (const auto& entry : extension_entries_) {
-            size += entry.length * 8 + 16;
-        }
-    }
-    return size;
+    return header_.extensions_size;
 }
 
 const bco::Buffer RtpPacket::payload() const
@@ -216,17 +331,20 @@ const bco::Buffer RtpPacket::payload() const
 
 size_t RtpPacket::size() const
 {
-    return buffer_.size();
+    return header_.size;
 }
 
 bool RtpPacket::empty_payload() const
 {
-    return size() == kFixedHeaderSize;
+    return payload_size() == 0;
 }
 
 const bco::Buffer RtpPacket::data() const
 {
-    return buffer_;
+    if (buffer_.size() == header_.size) {
+        return buffer_;
+    }
+    return buffer_.subbuf(0, header_.size);
 }
 
 //const ExtraRtpInfo& RtpPacket::extra_info() const
@@ -246,66 +364,120 @@ void RtpPacket::set_marker(bool marker)
     } else {
         buffer_[1] &= 0b0111'1111;
     }
+    header_.marker = marker;
 }
 
 void RtpPacket::set_payload_type(uint8_t pt)
 {
     uint8_t payload_type = buffer_[1] & 0b1000'0000;
     buffer_[1] = payload_type | pt;
+    header_.payload_type = pt & 0b0111'1111;
 }
 
 void RtpPacket::set_sequence_number(uint16_t seq)
 {
     buffer_.write_big_endian_at(2, seq);
+    header_.sequence_number = seq;
 }
 
 void RtpPacket::set_timestamp(uint32_t timestamp)
 {
     buffer_.write_big_endian_at(4, timestamp);
+    header_.timestamp = timestamp;
 }
 
 void RtpPacket::set_ssrc(uint32_t ssrc)
 {
     buffer_.write_big_endian_at(8, ssrc);
+    header_.ssrc = ssrc;
 }
 
 void RtpPacket::set_csrcs(std::span<uint32_t> csrcs)
 {
-    if (csrcs_size() != 0)
+    if (csrcs_size() != 0 || !extension_entries_.empty())
         return;
     uint8_t cc = static_cast<uint8_t>(csrcs.size());
     buffer_[0] = buffer_[0] | cc;
+    append_n_bytes(cc * sizeof(uint32_t));
     for (size_t i = 0; i < csrcs.size(); i++) {
         buffer_.write_big_endian_at(kFixedHeaderSize + i * sizeof(uint32_t), csrcs[i]);
     }
+    header_.csrcs_size = cc;
+    header_.headers_size = static_cast<uint16_t>(kFixedHeaderSize + cc * sizeof(uint32_t));
 }
 
-void RtpPacket::set_payload(const std::span<uint8_t>& payload)
+void RtpPacket::finish_extensions()
 {
-    auto ext_bytes = buffer_.data().back().size() - 4;
+    // Already finished once the block length is known.
+    if (extension_entries_.empty() || header_.extensions_size != 0) {
+        return;
+    }
+    const size_t extension_offset = kFixedHeaderSize + csrcs_size() * sizeof(uint32_t);
+    auto ext_bytes = header_.size - extension_offset - 4;
     auto mod = ext_bytes % 4;
     if (mod != 0) {
-        buffer_.push_back(std::vector<uint8_t>(4 - mod, 0));
-        buffer_.write_big_endian_at(kFixedHeaderSize + csrcs_size() * sizeof(uint32_t) + sizeof(uint16_t), uint16_t(ext_bytes / 4 + 1));
-    } else {
-        buffer_.write_big_endian_at(kFixedHeaderSize + csrcs_size() * sizeof(uint32_t) + sizeof(uint16_t), uint16_t(ext_bytes / 4));
+        append_n_bytes(4 - mod);
+        ext_bytes += 4 - mod;
     }
+    buffer_.write_big_endian_at(extension_offset + sizeof(uint16_t), uint16_t(ext_bytes / 4));
+    header_.extensions_size = static_cast<uint16_t>(ext_bytes);
+    header_.headers_size = header_.size;
+}
+
+void RtpPacket::set_payload(const std::span<uint8_t>& payload)
+{
+    finish_extensions();
+    if (header_.size + payload.size() <= block_.size()) {
+        append(payload);
+        return;
+    }
+    leave_block();
     buffer_.push_back(payload, true);
+    header_.size += static_cast<uint16_t>(payload.size());
 }
 
 void RtpPacket::set_payload(std::vector<uint8_t>&& payload)
 {
-    auto ext_bytes = buffer_.data().back().size() - 4;
-    auto mod = ext_bytes % 4;
-    if (mod != 0) {
-        buffer_.push_back(std::vector<uint8_t>(4 - mod, 0));
-        buffer_.write_big_endian_at(kFixedHeaderSize + csrcs_size() * sizeof(uint32_t) + sizeof(uint16_t), uint16_t(ext_bytes / 4 + 1));
-    } else {
-        buffer_.write_big_endian_at(kFixedHeaderSize + csrcs_size() * sizeof(uint32_t) + sizeof(uint16_t), uint16_t(ext_bytes / 4));
+    finish_extensions();
+    if (header_.size + payload.size() <= block_.size()) {
+        append(payload);
+        return;
     }
+    leave_block();
+    header_.size += static_cast<uint16_t>(payload.size());
     buffer_.push_back(std::move(payload), true);
 }
 
+std::span<uint8_t> RtpPacket::allocate_payload(size_t size)
+{
+    finish_extensions();
+    const size_t offset = append_n_bytes(size, false);
+    if (!block_.empty()) {
+        return block_.subspan(offset, size);
+    }
+    return buffer_.data().back();
+}
+
+void RtpPacket::append_payload_reference(std::span<uint8_t> data, std::shared_ptr<const void> owner)
+{
+    finish_extensions();
+    leave_block();
+    buffer_.push_back(data, true);
+    header_.size += static_cast<uint16_t>(data.size());
+    payload_owner_ = std::move(owner);
+}
+
+void RtpPacket::set_padding(uint8_t padding_size)
+{
+    if (padding_size == 0) {
+        return;
+    }
+    buffer_[0] |= 0b0010'0000;
+    const size_t offset = append_n_bytes(padding_size);
+    buffer_[offset + padding_size - 1] = padding_size;
+    header_.padding_size = padding_size;
+}
+
 //void RtpPacket::set_frame(Frame frame)
 //{
 //    frame_ = frame;
@@ -317,12 +489,12 @@ void RtpPacket::parse()
 
 bco::Buffer RtpPacket::find_extension(RTPExtensionType type) const
 {
-    for (const auto& entry : extension_entries_) {
-        if (entry.type == type) {
-            return buffer_.subbuf(entry.offset, entry.length);
-        }
+    const uint8_t index = extension_index_[static_cast<size_t>(type)];
+    if (index == 0) {
+        return bco::Buffer();
     }
-    return bco::Buffer();
+    const ExtensionInfo& entry = extension_entries_[index - 1];
+    return buffer_.subbuf(entry.offset, entry.length);
 }
 
 void RtpPacket::promote_two_bytes_header_and_reserve_n_bytes(uint8_t n_bytes)
@@ -332,25 +504,24 @@ void RtpPacket::promote_two_bytes_header_and_reserve_n_bytes(uint8_t n_bytes)
         //һβext elemtwo bytes
         //16ֽڵxx
         //reserve n bytes
-        size_t pos = buffer_.size();
-        buffer_.push_back(std::vector<uint8_t>(4 + n_bytes), true);
-        uint16_t magic = static_cast<uint16_t>(0x1000);
-        buffer_.write_big_endian_at(pos, magic);
+        allocate_n_bytes_for_extension(n_bytes);
     } else {
         //uint16_t magic = 0x1'0000;
-        auto tmp = buffer_.data().back();
-        tmp[0] = 1;
-        tmp[1] = 0;
+        const size_t extension_offset = kFixedHeaderSize + csrcs_size() * sizeof(uint32_t);
+        buffer_.write_big_endian_at(extension_offset, static_cast<uint16_t>(0x1000));
         //ÿ extension element1ֽ
-        buffer_.push_back(std::vector<uint8_t>(extension_entries_.size() + n_bytes));
-        auto exts = extension_entries_.size();
-        for (auto it = extension_entries_.rbegin(); it != extension_entries_.rend(); it++) {
-            auto ext_index = &buffer_[it->offset];
-            ::memmove(ext_index + exts, ext_index, it->length);
-            *(ext_index - 1) = it->length;
-            *(ext_index - 2) = static_cast<uint8_t>(it->type);
-            it->offset += static_cast<uint16_t>(exts);
-            exts -= 1;
+        append_n_bytes(extension_entries_.size() + n_bytes);
+        // Element i moves up by i + 1 bytes, going backwards nothing that is
+        // still to be moved gets overwritten.
+        for (size_t exts = extension_entries_.size(); exts > 0; exts--) {
+            ExtensionInfo& entry = extension_entries_[exts - 1];
+            const uint16_t offset = entry.offset + static_cast<uint16_t>(exts);
+            for (size_t i = entry.length; i > 0; i--) {
+                buffer_[offset + i - 1] = buffer_[entry.offset + i - 1];
+            }
+            buffer_[offset - 1] = entry.length;
+            buffer_[offset - 2] = extension_map_->id(entry.type);
+            entry.offset = offset;
         }
     }
 }
@@ -361,26 +532,58 @@ void RtpPacket::allocate_n_bytes_for_extension(uint8_t bytes)
         //һβext elem one byte
         //16ֽxx
         //reserve n bytes
-        auto ext = std::vector<uint8_t>(2 + bytes);
-        ext[0] = 0xBE;
-        ext[1] = 0xDE;
-        ext[2] = 0;
-        ext[3] = 0;
-        buffer_.push_back(std::move(ext), true);
+        const size_t offset = append_n_bytes(4 + bytes);
+        const uint16_t magic = extension_mode_ == ExtensionMode::kOneByte ? 0xBEDE : 0x1000;
+        buffer_.write_big_endian_at(offset, magic);
     } else {
-        buffer_.push_back(std::vector<uint8_t>(bytes));
+        append_n_bytes(bytes);
     }
 }
 
-RtpPacket::ExtensionInfo& RtpPacket::find_or_create_extension_info(RTPExtensionType type)
+size_t RtpPacket::append_n_bytes(size_t n, bool zeroed)
 {
-    for (ExtensionInfo& extension : extension_entries_) {
-        if (extension.type == type) {
-            return extension;
+    const size_t offset = header_.size;
+    if (offset + n <= block_.size()) {
+        if (zeroed) {
+            ::memset(block_.data() + offset, 0, n);
         }
+    } else {
+        leave_block();
+        buffer_.push_back(std::vector<uint8_t>(n), true);
+    }
+    header_.size = static_cast<uint16_t>(offset + n);
+    return offset;
+}
+
+void RtpPacket::append(std::span<uint8_t> data)
+{
+    const size_t offset = header_.size;
+    if (offset + data.size() <= block_.size()) {
+        ::memcpy(block_.data() + offset, data.data(), data.size());
+        header_.size = static_cast<uint16_t>(offset + data.size());
+    } else {
+        leave_block();
+        buffer_.push_back(data, true);
+        header_.size = static_cast<uint16_t>(offset + data.size());
+    }
+}
+
+void RtpPacket::leave_block()
+{
+    if (buffer_.size() != header_.size) {
+        buffer_ = buffer_.subbuf(0, header_.size);
+    }
+    block_ = {};
+}
+
+RtpPacket::ExtensionInfo& RtpPacket::find_or_create_extension_info(RTPExtensionType type)
+{
+    uint8_t& index = extension_index_[static_cast<size_t>(type)];
+    if (index == 0) {
+        extension_entries_.push_back(ExtensionInfo { type });
+        index = static_cast<uint8_t>(extension_entries_.size());
     }
-    extension_entries_.emplace_back(type);
-    return extension_entries_.back();
+    return extension_entries_[index - 1];
 }
 
 } // namespace brtc
\ No newline at end of file
@@ -2,18 +2,24 @@
 
 #include <cassert>
 #include <cstdint>
+#include <array>
 #include <vector>
 #include <span>
 #include <concepts>
 #include <variant>
 #include <bitset>
+#include <memory>
 #include <optional>
+#include <type_traits>
 
 #include <bco/buffer.h>
 
 #include <brtc/frame.h>
 
+#include "common/buffer_pool.h"
+#include "common/small_vector.h"
 #include "rtp/extension.h"
+#include "rtp/extension_map.h"
 #include "rtp/extra_rtp_info.h"
 #include "video/reference_finder/vp9_globals.h"
 #include "video/reference_finder/vp8_globals.h"
@@ -21,7 +27,10 @@
 namespace brtc
 {
 
-constexpr uint32_t kMaxNalusPerPacket = 10;
+// Extension entries kept inline in RtpPacket, more than that spill to the heap.
+constexpr uint32_t kInlineExtensionsPerPacket = 4;
+// NALUs kept inline in RTPVideoHeaderH264, a STAP-A with more spills to the heap.
+constexpr uint32_t kInlineNalusPerPacket = 8;
 constexpr uint32_t kH264StartCodeLength = 4;
 constexpr uint32_t kOneByteHeaderExtensionMaxId = 14;
 constexpr uint32_t kOneByteHeaderExtensionMaxValueSize = 16;
@@ -107,8 +116,7 @@ struct RTPVideoHeader {
 struct RTPVideoHeaderH264 : public RTPVideoHeader {
     H264NaluType nalu_type;
     H264PacketizationTypes packetization_type;
-    NaluInfo nalus[kMaxNalusPerPacket];
-    uint32_t nalus_length;
+    SmallVector<NaluInfo, kInlineNalusPerPacket> nalus;
     H264PacketizationMode packetization_mode;
     uint16_t picture_id;
     int64_t timestamp_local;
@@ -226,10 +234,32 @@ struct ReceivedFrame : public Frame {
     int64_t references[kMaxFrameReferences];
 };
 
+class RtpHeaderTemplate;
+
 class RtpPacket {
+public:
+    using VideoHeader = std::variant<RTPVideoHeader, RTPVideoHeaderH264, RTPVideoHeaderH265, RTPVideoHeaderVP8, RTPVideoHeaderVP9>;
+
 public:
     RtpPacket();
-    RtpPacket(bco::Buffer buff);
+    // |extension_map| resolves extension ids and must outlive the packet, null
+    // means RtpHeaderExtensionMap::default_map().
+    explicit RtpPacket(const RtpHeaderExtensionMap* extension_map);
+    RtpPacket(bco::Buffer buff, const RtpHeaderExtensionMap* extension_map = nullptr);
+    // |lease| keeps a pooled |buff| from being recycled while this packet lives.
+    RtpPacket(bco::Buffer buff, BufferPool::Lease lease, const RtpHeaderExtensionMap* extension_map = nullptr);
+    // A packet for sending that is serialized in place into one block taken
+    // from |pool|, which should be MTU sized. Header, extensions, payload and
+    // padding are written straight into the block, nothing else is allocated.
+    static RtpPacket create(BufferPool& pool, const RtpHeaderExtensionMap* extension_map = nullptr);
+    RtpPacket(const RtpPacket& other);
+    RtpPacket(RtpPacket&& other) = default;
+    RtpPacket& operator=(const RtpPacket& other);
+    RtpPacket& operator=(RtpPacket&& other) = default;
+    // Copy with header bytes of its own and the payload and padding shared
+    // with this packet, so a forwarder can rewrite the header once per
+    // destination without copying the payload. The video header is dropped.
+    RtpPacket share_payload() const;
 
     bool marker() const;
     uint8_t payload_type() const;
@@ -248,13 +278,26 @@ public:
     size_t size() const;
     bool empty_payload() const;
     const bco::Buffer data() const;
+    // RTPVideoHeader gives the common part of whichever codec header is held.
     template <typename T>
     const T& video_header() const {
-        return std::get<T>(video_header_);
+        const VideoHeader& header = video_header_ ? *video_header_ : empty_video_header();
+        if constexpr (std::is_same_v<T, RTPVideoHeader>) {
+            return std::visit([](const auto& h) -> const RTPVideoHeader& { return h; }, header);
+        } else {
+            return std::get<T>(header);
+        }
     }
     template <typename T>
     T& video_header() {
-        return std::get<T>(video_header_);
+        if (!video_header_) {
+            video_header_ = std::make_unique<VideoHeader>();
+        }
+        if constexpr (std::is_same_v<T, RTPVideoHeader>) {
+            return std::visit([](auto& h) -> RTPVideoHeader& { return h; }, *video_header_);
+        } else {
+            return std::get<T>(*video_header_);
+        }
     }
     //const ExtraRtpInfo& extra_info() const;
     //ExtraRtpInfo& extra_info();
@@ -269,12 +312,25 @@ public:
     bool set_extension(const typename T::value_type& ext);
     void set_payload(const std::span<uint8_t>& payload);
     void set_payload(std::vector<uint8_t>&& payload);
+    // Grows the payload by |size| bytes and returns them for the caller to
+    // fill, in place when the packet is built in a pooled block.
+    std::span<uint8_t> allocate_payload(size_t size);
+    // Appends |data| as its own span without copying it into the packet's
+    // block, |owner| keeps the memory alive for as long as the packet.
+    void append_payload_reference(std::span<uint8_t> data, std::shared_ptr<const void> owner);
+    // Appends |padding_size| bytes of RTP padding, must be called last.
+    void set_padding(uint8_t padding_size);
     template <typename T>
     void set_video_header(const T& header) {
-        video_header_ = header;
+        if (video_header_) {
+            *video_header_ = header;
+        } else {
+            video_header_ = std::make_unique<VideoHeader>(header);
+        }
     }
 
 private:
+    static const VideoHeader& empty_video_header();
     void parse();
     bco::Buffer find_extension(RTPExtensionType type) const;
     
@@ -291,13 +347,29 @@ private:
 
     void allocate_n_bytes_for_extension(uint8_t bytes);
 
+    // Grows the packet by |n| bytes, in place while the underlying block has
+    // room. Returns the offset of the first new byte.
+    size_t append_n_bytes(size_t n, bool zeroed = true);
+    void append(std::span<uint8_t> data);
+    // Stops building in place, later appends go to new spans.
+    void leave_block();
+
+    RtpPacket(const RtpHeaderExtensionMap* extension_map, bco::Buffer block, BufferPool::Lease lease);
+    RtpPacket(const RtpPacket& other, bco::Buffer buffer);
+
+    // Pads the extension block to a 32-bit boundary and writes its length.
+    void finish_extensions();
+
 private:
+    friend class RtpHeaderTemplate;
+
     struct ExtensionInfo {
+        ExtensionInfo() = default;
         explicit ExtensionInfo(RTPExtensionType _type)
             : ExtensionInfo(_type, 0, 0)
         {
         }
-        ExtensionInfo(RTPExtensionType _type, uint8_t _offset, uint8_t _length)
+        ExtensionInfo(RTPExtensionType _type, uint16_t _offset, uint8_t _length)
             : type(_type)
             , offset(_offset)
             , length(_length)
@@ -314,12 +386,41 @@ private:
 
     ExtensionInfo& find_or_create_extension_info(RTPExtensionType type);
 
+    // Decoded once by the parsing constructor and kept in sync by the setters,
+    // so the accessors are plain loads instead of walks over the buffer spans.
+    struct Header {
+        uint32_t timestamp = 0;
+        uint32_t ssrc = 0;
+        uint16_t sequence_number = 0;
+        // Bytes in use, |buffer_| may be a larger block the packet is built in.
+        uint16_t size = 0;
+        // Fixed header, CSRCs and the whole extension block.
+        uint16_t headers_size = 0;
+        // Extension elements and their padding, without the 4 bytes block header.
+        uint16_t extensions_size = 0;
+        uint8_t payload_type = 0;
+        uint8_t csrcs_size = 0;
+        uint8_t padding_size = 0;
+        bool marker = false;
+    };
+
 private:
+    Header header_;
+    const RtpHeaderExtensionMap* extension_map_;
     ExtensionMode extension_mode_ = ExtensionMode::kOneByte;
-    std::vector<ExtensionInfo> extension_entries_;
-    std::variant<RTPVideoHeader, RTPVideoHeaderH264, RTPVideoHeaderH265, RTPVideoHeaderVP8, RTPVideoHeaderVP9> video_header_;
+    SmallVector<ExtensionInfo, kInlineExtensionsPerPacket> extension_entries_;
+    // Index + 1 into |extension_entries_| by RTPExtensionType, 0 if absent.
+    std::array<uint8_t, RtpHeaderExtensionMap::kNumTypes> extension_index_ {};
+    // Kept out of line, the VP9 alternative alone is well over a kilobyte and
+    // most packets either have no codec header or a small one.
+    std::unique_ptr<VideoHeader> video_header_;
     //ExtraRtpInfo extra_rtp_info_;
     mutable bco::Buffer buffer_;
+    // The whole block |buffer_| is being serialized into, empty for parsed
+    // packets and once the packet outgrew it.
+    std::span<uint8_t> block_;
+    BufferPool::Lease lease_;
+    std::shared_ptr<const void> payload_owner_;
     //mutable Frame frame_;
 };
 
@@ -338,6 +439,9 @@ inline bool RtpPacket::get_extension(typename T::value_type& value) const
 template <typename T> requires RtpExtension<T>
 inline bool RtpPacket::set_extension(const typename T::value_type& value)
 {
+    if (extension_map_->id<T>() == RtpHeaderExtensionMap::kInvalidId) {
+        return false;
+    }
     buffer_[0] |= 0b0001'0000;
     auto buff = find_extension(T::id());
     if (buff.size() != 0) {
@@ -355,7 +459,7 @@ inline bool RtpPacket::set_extension(const typename T::value_type& value)
 template <typename T> requires RtpExtension<T>
 inline bool RtpPacket::need_promotion(const typename T::value_type& value) const
 {
-    uint32_t id = static_cast<uint32_t>(T::id());
+    uint32_t id = extension_map_->id<T>();
     assert(id != 15 && id != 0);
     return extension_mode_ == ExtensionMode::kOneByte
         && (id > kOneByteHeaderExtensionMaxId || T::value_size(value) > kOneByteHeaderExtensionMaxValueSize);
@@ -372,23 +476,25 @@ template <typename T> requires RtpExtension<T>
 bool RtpPacket::push_back_extension(const typename T::value_type& value)
 {
     constexpr size_t kFixedHeaderSize = 12;
-    uint8_t insert_pos;
+    uint16_t insert_pos;
     if (not extension_entries_.empty()) {
         insert_pos = extension_entries_.back().offset + extension_entries_.back().length;
     } else {
         insert_pos = kFixedHeaderSize + csrcs_size() * sizeof(uint32_t) + sizeof(uint32_t);
     }
-    const uint8_t id = static_cast<uint8_t>(T::id());
+    const uint8_t id = extension_map_->id<T>();
     const uint8_t value_size = T::value_size(value);
     if (extension_mode_ == ExtensionMode::kOneByte) {
         buffer_[insert_pos] = (id << 4) | (value_size - 1);
         T::write_to_buff(buffer_.subbuf(insert_pos + 1, value_size), value);
-        extension_entries_.push_back(ExtensionInfo { T::id(), insert_pos, uint8_t ( value_size + 1 ) });
+        extension_entries_.push_back(ExtensionInfo { T::id(), uint16_t(insert_pos + 1), value_size });
+        extension_index_[static_cast<size_t>(T::id())] = static_cast<uint8_t>(extension_entries_.size());
     } else {
         buffer_[insert_pos] = id;
         buffer_[insert_pos + 1] = value_size;
         T::write_to_buff(buffer_.subbuf(insert_pos + 2, value_size), value);
-        extension_entries_.push_back(ExtensionInfo { T::id(), insert_pos, uint8_t ( value_size + 2 ) });
+        extension_entries_.push_back(ExtensionInfo { T::id(), uint16_t(insert_pos + 2), value_size });
+        extension_index_[static_cast<size_t>(T::id())] = static_cast<uint8_t>(extension_entries_.size());
     }
     return true;
 }
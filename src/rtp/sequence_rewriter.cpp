@@ -0,0 +1,61 @@
+#include <algorithm>
+#include "common/sequence_number_util.h"
+#include "rtp/sequence_rewriter.h"
+
+namespace brtc {
+
+namespace {
+constexpr uint32_t kVideoClockRateKhz = 90;
+// How far behind the newest packet a reordered one is still forwarded.
+constexpr uint16_t kMaxReorderDistance = 1000;
+} // namespace
+
+void SequenceRewriter::switch_source()
+{
+    resync_ = true;
+}
+
+bool SequenceRewriter::rewrite(uint16_t sequence_number, uint32_t timestamp, int64_t now_ms, uint16_t& out_sequence_number, uint32_t& out_timestamp)
+{
+    if (resync_) {
+        resync_ = false;
+        base_sequence_number_ = sequence_number;
+        if (started_) {
+            // Continue right after the last packet sent, and advance the
+            // timestamp by the wall time since then, at least one tick so
+            // the new frame does not merge with the last one.
+            const int64_t elapsed_ms = std::max<int64_t>(now_ms - max_timestamp_ms_, 0);
+            const uint32_t step = std::max<uint32_t>(static_cast<uint32_t>(elapsed_ms) * kVideoClockRateKhz, 1);
+            sequence_number_offset_ = sequence_number - static_cast<uint16_t>(max_sequence_number_ + 1);
+            timestamp_offset_ = timestamp - (max_timestamp_ + step);
+        } else {
+            sequence_number_offset_ = 0;
+            timestamp_offset_ = 0;
+            max_sequence_number_ = sequence_number;
+            max_timestamp_ = timestamp;
+            max_timestamp_ms_ = now_ms;
+            started_ = true;
+        }
+    } else if (!webrtc::AheadOrAt(sequence_number, base_sequence_number_)) {
+        return false;
+    }
+    // The window of accepted packets follows the source, a fixed base would
+    // fall half the sequence space behind after 32768 packets and turn all
+    // of the following ones into late packets.
+    const uint16_t window_start = sequence_number - kMaxReorderDistance;
+    if (webrtc::AheadOf(window_start, base_sequence_number_)) {
+        base_sequence_number_ = window_start;
+    }
+    out_sequence_number = sequence_number - sequence_number_offset_;
+    out_timestamp = timestamp - timestamp_offset_;
+    if (webrtc::AheadOrAt(out_sequence_number, max_sequence_number_)) {
+        max_sequence_number_ = out_sequence_number;
+        if (out_timestamp != max_timestamp_) {
+            max_timestamp_ = out_timestamp;
+            max_timestamp_ms_ = now_ms;
+        }
+    }
+    return true;
+}
+
+} // namespace brtc
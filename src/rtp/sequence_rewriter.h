@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+
+namespace brtc {
+
+// Maps sequence numbers and timestamps of whichever source stream is being
+// forwarded onto one outgoing stream. The outgoing numbers stay contiguous
+// when forwarding moves to another source (simulcast layer), so receivers
+// see neither a sequence gap they would NACK nor a timestamp jump.
+class SequenceRewriter {
+public:
+    // Packets from now on come from another source, the first one handed to
+    // rewrite() anchors the new mapping.
+    void switch_source();
+    // False for a packet sent before the current mapping was anchored, such
+    // as a late one of the previous source, or one that arrives too far
+    // behind the newest packet. Neither must be forwarded.
+    bool rewrite(uint16_t sequence_number, uint32_t timestamp, int64_t now_ms, uint16_t& out_sequence_number, uint32_t& out_timestamp);
+
+private:
+    bool started_ = false;
+    bool resync_ = true;
+    uint16_t base_sequence_number_ = 0;
+    uint16_t sequence_number_offset_ = 0;
+    uint32_t timestamp_offset_ = 0;
+    uint16_t max_sequence_number_ = 0;
+    uint32_t max_timestamp_ = 0;
+    int64_t max_timestamp_ms_ = 0;
+};
+
+} // namespace brtc
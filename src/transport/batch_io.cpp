@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cerrno>
+#include "transport/batch_io.h"
+
+#ifdef __linux__
+#include <netinet/in.h>
+#endif
+
+namespace brtc {
+
+BatchIo::BatchIo(int fd)
+    : fd_(fd)
+{
+#ifdef __linux__
+    send_msgs_.resize(kMaxBatchSize);
+    recv_msgs_.resize(kMaxBatchSize);
+    recv_iovecs_.resize(kMaxBatchSize);
+#endif
+}
+
+bool BatchIo::enabled() const
+{
+#ifdef __linux__
+    return fd_ >= 0;
+#else
+    return false;
+#endif
+}
+
+int BatchIo::send(std::span<const bco::Buffer> packets, const bco::net::Address& addr, uint64_t& syscalls)
+{
+#ifdef __linux__
+    if (!enabled()) {
+        return -1;
+    }
+    sockaddr_storage storage = addr.to_storage();
+    socklen_t addr_len = storage.ss_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+    size_t sent = 0;
+    while (sent < packets.size()) {
+        const size_t count = std::min(kMaxBatchSize, packets.size() - sent);
+        // Collect all iovecs first, msg_iov may only point into the vector
+        // once it stops growing.
+        send_iovecs_.clear();
+        for (size_t i = 0; i < count; i++) {
+            auto spans = packets[sent + i].data();
+            send_msgs_[i].msg_hdr.msg_iovlen = spans.size();
+            for (auto span : spans) {
+                send_iovecs_.push_back(iovec { span.data(), span.size() });
+            }
+        }
+        size_t iov_index = 0;
+        for (size_t i = 0; i < count; i++) {
+            msghdr& hdr = send_msgs_[i].msg_hdr;
+            hdr.msg_name = &storage;
+            hdr.msg_namelen = addr_len;
+            hdr.msg_iov = &send_iovecs_[iov_index];
+            hdr.msg_control = nullptr;
+            hdr.msg_controllen = 0;
+            hdr.msg_flags = 0;
+            iov_index += hdr.msg_iovlen;
+        }
+        int ret = ::sendmmsg(fd_, send_msgs_.data(), static_cast<unsigned int>(count), 0);
+        syscalls++;
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // EAGAIN and friends: drop the rest like a failed sendto would.
+            break;
+        }
+        sent += ret;
+    }
+    return sent == 0 ? -1 : static_cast<int>(sent);
+#else
+    return -1;
+#endif
+}
+
+int BatchIo::recv(std::span<bco::Buffer> buffers, std::span<int> sizes, sockaddr_storage* sources)
+{
+#ifdef __linux__
+    if (!enabled()) {
+        return 0;
+    }
+    const size_t count = std::min({ kMaxBatchSize, buffers.size(), sizes.size() });
+    for (size_t i = 0; i < count; i++) {
+        auto span = buffers[i].data().front();
+        recv_iovecs_[i] = iovec { span.data(), span.size() };
+        msghdr& hdr = recv_msgs_[i].msg_hdr;
+        hdr = msghdr {};
+        hdr.msg_iov = &recv_iovecs_[i];
+        hdr.msg_iovlen = 1;
+        if (sources != nullptr) {
+            hdr.msg_name = &sources[i];
+            hdr.msg_namelen = sizeof(sockaddr_storage);
+        }
+    }
+    int ret = ::recvmmsg(fd_, recv_msgs_.data(), static_cast<unsigned int>(count), MSG_DONTWAIT, nullptr);
+    if (ret <= 0) {
+        return 0;
+    }
+    for (int i = 0; i < ret; i++) {
+        sizes[i] = static_cast<int>(recv_msgs_[i].msg_len);
+    }
+    return ret;
+#else
+    return 0;
+#endif
+}
+
+} // namespace brtc
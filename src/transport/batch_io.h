@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <bco/buffer.h>
+#include <bco/net/udp.h>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+struct sockaddr_storage;
+
+namespace brtc {
+
+// Multi-datagram socket I/O (recvmmsg/sendmmsg) on Linux. On other platforms
+// enabled() is false and callers stay on the single datagram path.
+class BatchIo {
+public:
+    static constexpr size_t kMaxBatchSize = 32;
+
+    BatchIo() = default;
+    explicit BatchIo(int fd);
+    bool enabled() const;
+
+    // Sends every buffer as its own datagram, the spans of a multi-span buffer
+    // are gathered by the kernel. Returns the number of datagrams accepted by
+    // the kernel and how many syscalls it took, or -1 if nothing was sent.
+    int send(std::span<const bco::Buffer> packets, const bco::net::Address& addr, uint64_t& syscalls);
+
+    // Reads datagrams that are already queued on the socket without blocking.
+    // Each buffer must be a single span, |sizes| receives the datagram lengths
+    // and |sources|, when given, room for as many addresses as |buffers| the
+    // addresses they came from.
+    int recv(std::span<bco::Buffer> buffers, std::span<int> sizes, sockaddr_storage* sources = nullptr);
+
+private:
+    int fd_ = -1;
+#ifdef __linux__
+    std::vector<iovec> send_iovecs_;
+    std::vector<mmsghdr> send_msgs_;
+    std::vector<iovec> recv_iovecs_;
+    std::vector<mmsghdr> recv_msgs_;
+#endif
+};
+
+} // namespace brtc
@@ -0,0 +1,69 @@
+#include <array>
+#include "transport/demux.h"
+
+namespace brtc {
+
+namespace {
+
+constexpr uint8_t kMinRtcpPayloadType = 64;
+constexpr uint8_t kRtcpPayloadTypeCount = 32;
+
+constexpr std::array<DatagramType, 256> make_first_byte_types()
+{
+    std::array<DatagramType, 256> types {};
+    for (size_t i = 0; i < types.size(); i++) {
+        if (i <= 3) {
+            types[i] = DatagramType::Stun;
+        } else if (i >= 20 && i <= 63) {
+            types[i] = DatagramType::Dtls;
+        } else if (i >= 80 && i <= 127) {
+            // QUIC short header, 64-79 stay TURN channels.
+            types[i] = DatagramType::Quic;
+        } else if (i >= 128 && i <= 191) {
+            types[i] = DatagramType::Rtp;
+        } else if (i >= 192) {
+            // QUIC long header.
+            types[i] = DatagramType::Quic;
+        } else {
+            // ZRTP and TURN channels, nothing here speaks them.
+            types[i] = DatagramType::Unknown;
+        }
+    }
+    return types;
+}
+constexpr std::array<DatagramType, 256> kFirstByteTypes = make_first_byte_types();
+
+// Fixed header of each type, indexed by DatagramType.
+constexpr std::array<size_t, kDatagramTypeCount> kMinDatagramSizes {
+    1, // Unknown
+    20, // Stun
+    13, // Dtls
+    12, // Rtp
+    4, // Rtcp
+    1, // Quic
+};
+
+} // namespace
+
+DatagramType classify_datagram(const bco::Buffer& datagram)
+{
+    const size_t size = datagram.size();
+    if (size < 2) {
+        return DatagramType::Unknown;
+    }
+    DatagramType type = kFirstByteTypes[datagram[0]];
+    if (type == DatagramType::Rtp) {
+        // RTCP packet types 192-223 read as RTP payload types 64-95 with the
+        // marker bit set.
+        const uint8_t pt = datagram[1] & 0x7F;
+        if (static_cast<uint8_t>(pt - kMinRtcpPayloadType) < kRtcpPayloadTypeCount) {
+            type = DatagramType::Rtcp;
+        }
+    }
+    if (size < kMinDatagramSizes[static_cast<size_t>(type)]) {
+        return DatagramType::Unknown;
+    }
+    return type;
+}
+
+} // namespace brtc
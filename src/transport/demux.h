@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <bco/buffer.h>
+
+namespace brtc {
+
+// What a datagram received on the shared socket carries, told apart by its
+// first byte as RFC 7983 (with the QUIC ranges of RFC 9443) lays it out.
+enum class DatagramType : uint8_t {
+    Unknown,
+    Stun,
+    Dtls,
+    Rtp,
+    Rtcp,
+    Quic,
+};
+
+constexpr size_t kDatagramTypeCount = static_cast<size_t>(DatagramType::Quic) + 1;
+
+// One table lookup on the first byte, RTP and RTCP are then split on the
+// payload type (RFC 5761). Datagrams too short for their type are Unknown.
+DatagramType classify_datagram(const bco::Buffer& datagram);
+
+} // namespace brtc
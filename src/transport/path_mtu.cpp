@@ -0,0 +1,156 @@
+#include <algorithm>
+#include "transport/path_mtu.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+namespace brtc {
+
+namespace {
+// Gives up on a size after this many probes of it went unacknowledged.
+constexpr uint32_t kMaxProbes = 3;
+// The search stops once the unknown range is narrower than this.
+constexpr size_t kSearchGranularity = 32;
+// RTCP lengths count 32-bit words.
+constexpr size_t kProbeAlignment = 4;
+
+constexpr uint8_t kRtcpVersion = 2;
+constexpr uint8_t kRtcpApp = 204;
+constexpr uint8_t kProbeSubtype = 0;
+constexpr uint8_t kAckSubtype = 1;
+constexpr uint32_t kPathMtuName = 0x504D5455; // "PMTU"
+// V/P/subtype, PT, length, SSRC, name.
+constexpr size_t kAppHeaderSize = 12;
+constexpr size_t kAckSize = kAppHeaderSize + 4;
+
+size_t align_down(size_t size)
+{
+    return size - size % kProbeAlignment;
+}
+
+bco::Buffer build_app_packet(uint8_t subtype, size_t size)
+{
+    bco::Buffer packet { size };
+    packet[0] = static_cast<uint8_t>(kRtcpVersion << 6 | subtype);
+    packet[1] = kRtcpApp;
+    packet.write_big_endian_at(2, static_cast<uint16_t>(size / 4 - 1));
+    packet.write_big_endian_at(4, uint32_t { 0 });
+    packet.write_big_endian_at(8, kPathMtuName);
+    return packet;
+}
+
+} // namespace
+
+PathMtuProber::PathMtuProber(size_t max_datagram_size)
+    : ceiling_(align_down(std::max(max_datagram_size, kBaseDatagramSize)))
+{
+}
+
+size_t PathMtuProber::next_probe()
+{
+    if (probe_size_ != 0 && ++lost_probes_ >= kMaxProbes) {
+        ceiling_ = probe_size_ - kProbeAlignment;
+        probe_size_ = 0;
+        lost_probes_ = 0;
+    }
+    if (probe_size_ == 0) {
+        if (done()) {
+            return 0;
+        }
+        if (!ceiling_probed_) {
+            ceiling_probed_ = true;
+            probe_size_ = ceiling_;
+        } else {
+            probe_size_ = align_down((confirmed_ + ceiling_) / 2);
+        }
+    }
+    return probe_size_;
+}
+
+void PathMtuProber::on_probe_acked(size_t size)
+{
+    // Late acks of earlier probes still prove their size got through.
+    confirmed_ = std::max(confirmed_, std::min(size, ceiling_));
+    if (probe_size_ != 0 && size >= probe_size_) {
+        probe_size_ = 0;
+        lost_probes_ = 0;
+    }
+}
+
+bool PathMtuProber::done() const
+{
+    return probe_size_ == 0 && ceiling_ < confirmed_ + kSearchGranularity;
+}
+
+size_t datagram_size_ceiling(const PathMtuConfig& config)
+{
+    const size_t size = std::max(config.max_datagram_size, kMinDatagramSize);
+    return config.probe ? std::max(size, PathMtuProber::kBaseDatagramSize) : size;
+}
+
+bco::Buffer build_path_mtu_probe(size_t size)
+{
+    return build_app_packet(kProbeSubtype, align_down(std::max(size, kAckSize)));
+}
+
+bco::Buffer build_path_mtu_ack(size_t probe_size)
+{
+    bco::Buffer packet = build_app_packet(kAckSubtype, kAckSize);
+    packet.write_big_endian_at(kAppHeaderSize, static_cast<uint32_t>(probe_size));
+    return packet;
+}
+
+std::optional<PathMtuMessage> parse_path_mtu_message(const bco::Buffer& datagram)
+{
+    if (datagram.size() < kAckSize || datagram[0] >> 6 != kRtcpVersion || datagram[1] != kRtcpApp) {
+        return std::nullopt;
+    }
+    uint32_t name = 0;
+    datagram.read_big_endian_at(8, name);
+    if (name != kPathMtuName) {
+        return std::nullopt;
+    }
+    switch (datagram[0] & 0x1F) {
+    case kProbeSubtype:
+        return PathMtuMessage { PathMtuMessage::Kind::kProbe, datagram.size() };
+    case kAckSubtype: {
+        uint32_t size = 0;
+        datagram.read_big_endian_at(kAppHeaderSize, size);
+        return PathMtuMessage { PathMtuMessage::Kind::kAck, size };
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+bool set_dont_fragment(int fd)
+{
+    // The socket is either family, whichever option applies is enough.
+#if defined(__linux__)
+    int v4 = IP_PMTUDISC_PROBE;
+    int v6 = IPV6_PMTUDISC_PROBE;
+    bool ok = ::setsockopt(fd, IPPROTO_IP, IP_MTU_DISCOVER, &v4, sizeof(v4)) == 0;
+    ok = ::setsockopt(fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &v6, sizeof(v6)) == 0 || ok;
+    return ok;
+#elif defined(_WIN32)
+    DWORD on = 1;
+    bool ok = ::setsockopt(fd, IPPROTO_IP, IP_DONTFRAGMENT, reinterpret_cast<const char*>(&on), sizeof(on)) == 0;
+    ok = ::setsockopt(fd, IPPROTO_IPV6, IPV6_DONTFRAG, reinterpret_cast<const char*>(&on), sizeof(on)) == 0 || ok;
+    return ok;
+#elif defined(IP_DONTFRAG)
+    int on = 1;
+    bool ok = ::setsockopt(fd, IPPROTO_IP, IP_DONTFRAG, &on, sizeof(on)) == 0;
+    ok = ::setsockopt(fd, IPPROTO_IPV6, IPV6_DONTFRAG, &on, sizeof(on)) == 0 || ok;
+    return ok;
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+} // namespace brtc
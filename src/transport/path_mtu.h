@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <bco/buffer.h>
+#include <brtc/interface.h>
+
+namespace brtc {
+
+// Searches the largest datagram the path carries (DPLPMTUD, RFC 8899) with
+// DF set probes the peer acknowledges. The ceiling is tried first, which is
+// all it takes on a jumbo frame LAN, then it bisects between the largest
+// acknowledged size and the smallest lost one.
+class PathMtuProber {
+public:
+    // 1280 byte IPv6 minimum MTU less the IPv6 and UDP headers, fits any path.
+    static constexpr size_t kBaseDatagramSize = 1232;
+
+public:
+    explicit PathMtuProber(size_t max_datagram_size);
+
+    // Size of the probe to send now, 0 once the search is over. Called once
+    // per probe interval, a probe still unacknowledged by then counts as lost.
+    size_t next_probe();
+    void on_probe_acked(size_t size);
+    // Largest acknowledged size.
+    size_t datagram_size() const { return confirmed_; }
+    bool done() const;
+
+private:
+    size_t confirmed_ = kBaseDatagramSize;
+    size_t ceiling_;
+    size_t probe_size_ = 0;
+    uint32_t lost_probes_ = 0;
+    bool ceiling_probed_ = false;
+};
+
+// 576 byte minimum IPv4 MTU less the IPv4 and UDP headers, smaller
+// configured sizes are raised to it.
+constexpr size_t kMinDatagramSize = 548;
+
+// Largest datagram a transport with |config| will ever send, what packet
+// buffers have to hold. Probing may go past a configured size below where
+// it starts.
+size_t datagram_size_ceiling(const PathMtuConfig& config);
+
+// Probes and acks are RTCP APP packets named "PMTU".
+struct PathMtuMessage {
+    enum class Kind {
+        kProbe,
+        kAck,
+    };
+    Kind kind;
+    // Probe: its own size. Ack: the size of the acknowledged probe.
+    size_t size;
+};
+
+bco::Buffer build_path_mtu_probe(size_t size);
+bco::Buffer build_path_mtu_ack(size_t probe_size);
+std::optional<PathMtuMessage> parse_path_mtu_message(const bco::Buffer& datagram);
+
+// Sets DF on outgoing datagrams and stops the kernel from fragmenting or
+// clamping them to a cached path MTU, so oversized probes are lost instead.
+bool set_dont_fragment(int fd);
+
+} // namespace brtc
@@ -2,7 +2,7 @@
 
 namespace brtc {
 
-void brtc::QuicTransport::on_recv_data(bco::Buffer buff)
+void brtc::QuicTransport::on_recv_data(bco::Buffer buff, BufferPool::Lease lease)
 {
 }
 
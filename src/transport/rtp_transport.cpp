@@ -2,107 +2,83 @@
 
 namespace brtc {
 
-namespace {
-
-enum class PacketType {
-    Unknown,
-    Rtp,
-    Rtcp
-};
-
-constexpr uint8_t kRtpVersion = 2;
-constexpr size_t kMinRtcpPacketLen = 4;
-constexpr size_t kMinRtpPacketLen = 12;
+RtpTransport::RtpTransport(std::function<void(const bco::Buffer&)> send_func,
+    std::function<void(std::span<const bco::Buffer>)> send_batch_func)
+    : send_func_(send_func)
+    , send_batch_func_(send_batch_func)
+{
+}
 
-bool is_rtp(const bco::Buffer& buff)
+bco::Task<RtpPacket> RtpTransport::recv_rtp_packet()
 {
-    //Ĭֻһspan
-    auto data = buff.data();
-    if (data.empty()) {
-        return false;
-    }
-    auto buffer = data.front();
-    if (buffer.size() < kMinRtpPacketLen) {
-        return false;
-    }
-    return buffer[0] >> 6 == kRtpVersion;
+    return rtp_packets_.recv();
 }
 
-bool is_rtcp(const bco::Buffer& buff)
+bco::Task<RtpPacket> RtpTransport::recv_rtp_packet(uint32_t ssrc)
 {
-    //Ĭֻһspan
-    auto data = buff.data();
-    if (data.empty()) {
-        return false;
-    }
-    auto buffer = data.front();
-    if (buffer.size() < kMinRtcpPacketLen) {
-        return false;
+    auto stream = rtp_streams_.find(ssrc);
+    if (stream == nullptr) {
+        return rtp_packets_.recv();
     }
-    if (buffer[0] >> 6 != kRtpVersion) {
-        return false;
-    }
-    uint8_t pt = buffer[1] & 0x7F;
-    return (63 < pt) && (pt < 96);
+    return (*stream)->recv();
 }
 
-PacketType infer_packet_type(const bco::Buffer& buff)
+bco::Task<RtcpPacket> RtpTransport::recv_rtcp_packet()
 {
-    if (is_rtcp(buff)) {
-        return PacketType::Rtcp;
-    } else if (is_rtp(buff)) {
-        return PacketType::Rtp;
-    } else {
-        return PacketType::Unknown;
-    }
+    return rtcp_packets_.recv();
 }
 
-} // namespace
+void RtpTransport::send_packet(const RtpPacket& packet)
+{
+    send_func_(packet.data());
+}
 
-RtpTransport::RtpTransport(std::function<void(const bco::Buffer&)> send_func)
-    : send_func_(send_func)
+void RtpTransport::send_packets(std::span<const RtpPacket> packets)
 {
+    send_batch_.clear();
+    for (const auto& packet : packets) {
+        send_batch_.push_back(packet.data());
+    }
+    send_batch_func_(send_batch_);
 }
 
-bco::Task<RtpPacket> RtpTransport::recv_rtp_packet()
+void RtpTransport::send_packet(const RtcpPacket&)
 {
-    return rtp_packets_.recv();
+    //send_func_(packet.data());
 }
 
-bco::Task<RtcpPacket> RtpTransport::recv_rtcp_packet()
+void RtpTransport::set_extension_map(const RtpHeaderExtensionMap& extension_map)
 {
-    return rtcp_packets_.recv();
+    extension_map_ = extension_map;
 }
 
-void RtpTransport::send_packet(const RtpPacket& packet)
+bool RtpTransport::add_rtp_stream(uint32_t ssrc)
 {
-    send_func_(packet.data());
+    return rtp_streams_.insert(ssrc, std::make_unique<bco::Channel<RtpPacket>>());
 }
 
-void RtpTransport::send_packet(const RtcpPacket&)
+bool RtpTransport::remove_rtp_stream(uint32_t ssrc)
 {
-    //send_func_(packet.data());
+    return rtp_streams_.erase(ssrc);
 }
 
-void RtpTransport::on_recv_data(bco::Buffer buff)
+void RtpTransport::on_recv_rtp(bco::Buffer buff, BufferPool::Lease lease)
 {
-    //parse Buffer -> RtpPacket
-    PacketType type = infer_packet_type(buff);
-    switch (type) {
-    case PacketType::Rtcp: {
-        RtcpPacket packet;
-        rtcp_packets_.send(packet);
-        break;
-    }
-    case PacketType::Rtp: {
-        RtpPacket packet { buff };
-        //packet
-        rtp_packets_.send(packet);
-        break;
-    }
-    default:
-        break;
+    RtpPacket packet { std::move(buff), std::move(lease), &extension_map_ };
+    //packet
+    auto stream = rtp_streams_.find(packet.ssrc());
+    if (stream != nullptr) {
+        (*stream)->send(std::move(packet));
+    } else {
+        rtp_packets_.send(std::move(packet));
     }
 }
 
+void RtpTransport::on_recv_rtcp(bco::Buffer, BufferPool::Lease)
+{
+    //parse Buffer -> RtcpPacket
+    RtcpPacket packet;
+    rtcp_packets_.send(packet);
+}
+
 } // namespace brtc
@@ -1,28 +1,50 @@
 #pragma once
-#include <mutex>
+#include <memory>
 #include <queue>
+#include <span>
+#include <vector>
 
 #include <bco/coroutine/task.h>
 #include <bco/coroutine/channel.h>
 
+#include "common/buffer_pool.h"
+#include "common/ssrc_map.h"
 #include "rtp/rtp.h"
 
 namespace brtc {
 
 class RtpTransport {
 public:
-    RtpTransport(std::function<void(const bco::Buffer&)> send_func);
+    RtpTransport(std::function<void(const bco::Buffer&)> send_func,
+        std::function<void(std::span<const bco::Buffer>)> send_batch_func);
+    // Packets whose SSRC has no stream of its own.
     bco::Task<RtpPacket> recv_rtp_packet();
+    // Packets of a stream added with add_rtp_stream(), the ones without a
+    // stream of their own if |ssrc| was never added.
+    bco::Task<RtpPacket> recv_rtp_packet(uint32_t ssrc);
     bco::Task<RtcpPacket> recv_rtcp_packet();
     void send_packet(const RtpPacket& packet);
     void send_packet(const RtcpPacket& packet);
-    void on_recv_data(bco::Buffer buff);
+    void send_packets(std::span<const RtpPacket> packets);
+    // Datagrams already classified by Transport, see classify_datagram().
+    void on_recv_rtp(bco::Buffer buff, BufferPool::Lease lease);
+    void on_recv_rtcp(bco::Buffer buff, BufferPool::Lease lease);
+    // Ids negotiated for incoming packets, call before data starts flowing.
+    void set_extension_map(const RtpHeaderExtensionMap& extension_map);
+    // Gives |ssrc| its own queue, many streams can share one socket this way.
+    // Same context as on_recv_rtp(), false if |ssrc| already has one.
+    bool add_rtp_stream(uint32_t ssrc);
+    // Only once nothing waits in recv_rtp_packet(|ssrc|) any more.
+    bool remove_rtp_stream(uint32_t ssrc);
 
 private:
-    std::mutex mutex_;
     bco::Channel<RtpPacket> rtp_packets_;
+    SsrcMap<std::unique_ptr<bco::Channel<RtpPacket>>> rtp_streams_;
     bco::Channel<RtcpPacket> rtcp_packets_;
     std::function<void(const bco::Buffer&)> send_func_;
+    std::function<void(std::span<const bco::Buffer>)> send_batch_func_;
+    std::vector<bco::Buffer> send_batch_;
+    RtpHeaderExtensionMap extension_map_;
 };
 
 } // namespace
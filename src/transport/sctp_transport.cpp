@@ -2,7 +2,7 @@
 
 namespace brtc {
 
-void SctpTransport::on_recv_data(bco::Buffer buff)
+void SctpTransport::on_recv_data(bco::Buffer buff, BufferPool::Lease lease)
 {
 }
 
@@ -1,12 +1,13 @@
 #pragma once
 #include <bco/buffer.h>
+#include "common/buffer_pool.h"
 
 namespace brtc {
 
 class SctpTransport {
 public:
     SctpTransport() = default;
-    void on_recv_data(bco::Buffer buff);
+    void on_recv_data(bco::Buffer buff, BufferPool::Lease lease);
 };
 
 } // namespace
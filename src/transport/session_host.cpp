@@ -0,0 +1,300 @@
+#include <cstring>
+#include "transport/session_host.h"
+#include "transport/transport.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <pthread.h>
+#endif
+#if defined(__linux__)
+#include <linux/filter.h>
+#include <sched.h>
+#endif
+
+namespace brtc {
+
+namespace {
+constexpr uint32_t kGoldenRatio = 0x9E3779B1;
+constexpr uint32_t kSteeringShift = 16;
+// As for Transport, bounds the batched reads per wakeup of a shard.
+constexpr size_t kMaxDrainRounds = 4;
+
+// The kernel program has to do the same, keep the two in step.
+size_t steer(uint32_t address, uint16_t port, size_t shard_count)
+{
+    const uint32_t hash = (address ^ port) * kGoldenRatio;
+    return (hash >> kSteeringShift) % shard_count;
+}
+
+uint32_t read_big_endian(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 | static_cast<uint32_t>(data[2]) << 8 | data[3];
+}
+} // namespace
+
+SessionHostImpl::Shard::Shard(const SessionHost::Shard& info, const PathMtuConfig& path_mtu)
+    : socket(info.socket)
+    , context(info.context)
+    , core(info.core)
+    , recv_buffers(Transport::recv_buffer_size(path_mtu), Transport::kRecvBufferPoolCapacity)
+    , batch_io(socket.fd())
+{
+    // For every session of the shard at once, they all probe with the host's
+    // config.
+    if (path_mtu.probe) {
+        set_dont_fragment(socket.fd());
+    }
+}
+
+size_t SessionHostImpl::PeerKeyHash::operator()(const PeerKey& key) const
+{
+    size_t hash = key.port;
+    for (uint8_t byte : key.address) {
+        hash = hash * 31 + byte;
+    }
+    return hash;
+}
+
+SessionHostImpl::SessionHostImpl(std::vector<SessionHost::Shard>&& shards, const PathMtuConfig& path_mtu)
+    : path_mtu_(path_mtu)
+{
+    for (const auto& shard : shards) {
+        shards_.push_back(std::make_shared<Shard>(shard, path_mtu_));
+    }
+}
+
+size_t SessionHostImpl::shard_count() const
+{
+    return shards_.size();
+}
+
+size_t SessionHostImpl::shard_of(const bco::net::Address& remote_addr) const
+{
+    return steering_index(remote_addr.to_storage(), shards_.size());
+}
+
+TransportInfo SessionHostImpl::transport_info(const bco::net::Address& remote_addr)
+{
+    TransportInfo info;
+    info.socket = shards_[shard_of(remote_addr)]->socket;
+    info.remote_addr = remote_addr;
+    info.path_mtu = path_mtu_;
+    info.host = shared_from_this();
+    return info;
+}
+
+std::shared_ptr<bco::Context> SessionHostImpl::context(const bco::net::Address& remote_addr) const
+{
+    return shards_[shard_of(remote_addr)]->context;
+}
+
+void SessionHostImpl::start()
+{
+    if (shards_.size() > 1) {
+        attach_reuse_port_steering(shards_.front()->socket.fd(), shards_.size());
+    }
+    for (auto& shard : shards_) {
+        shard->context->spawn(std::bind(&SessionHostImpl::recv_loop, weak_from_this(), shard));
+    }
+}
+
+void SessionHostImpl::stop()
+{
+    stop_ = true;
+}
+
+void SessionHostImpl::attach(const bco::net::Address& remote_addr, Transport* transport)
+{
+    queue_change(remote_addr, transport, true);
+}
+
+void SessionHostImpl::detach(const bco::net::Address& remote_addr, Transport* transport)
+{
+    queue_change(remote_addr, transport, false);
+}
+
+void SessionHostImpl::queue_change(const bco::net::Address& remote_addr, Transport* transport, bool attach)
+{
+    Shard& shard = *shards_[shard_of(remote_addr)];
+    std::lock_guard lock { shard.changes_mutex };
+    shard.changes.push_back(SessionChange { peer_key(remote_addr.to_storage()), transport, attach });
+    shard.has_changes.store(true, std::memory_order_release);
+}
+
+void SessionHostImpl::apply_changes(Shard& shard)
+{
+    if (!shard.has_changes.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::vector<SessionChange> changes;
+    {
+        std::lock_guard lock { shard.changes_mutex };
+        changes.swap(shard.changes);
+        shard.has_changes.store(false, std::memory_order_relaxed);
+    }
+    // In the order they were made, a peer may move between two transports.
+    for (const auto& change : changes) {
+        if (change.attach) {
+            shard.sessions[change.key] = change.transport;
+            continue;
+        }
+        auto it = shard.sessions.find(change.key);
+        if (it != shard.sessions.end() && it->second == change.transport) {
+            shard.sessions.erase(it);
+        }
+    }
+}
+
+void SessionHostImpl::dispatch(Shard& shard, bco::Buffer datagram, BufferPool::Lease lease, const sockaddr_storage& source)
+{
+    // Per datagram, the previous one may have ended a session.
+    apply_changes(shard);
+    auto it = shard.sessions.find(peer_key(source));
+    if (it != shard.sessions.end()) {
+        it->second->on_recv_datagram(std::move(datagram), std::move(lease));
+    }
+}
+
+void SessionHostImpl::drain_socket(Shard& shard)
+{
+    for (size_t round = 0; round < kMaxDrainRounds; round++) {
+        for (size_t i = 0; i < shard.batch_buffers.size(); i++) {
+            if (shard.batch_buffers[i].size() == 0) {
+                std::tie(shard.batch_buffers[i], shard.batch_leases[i]) = shard.recv_buffers.acquire();
+            }
+        }
+        int received = shard.batch_io.recv(shard.batch_buffers, shard.batch_sizes, shard.batch_sources.data());
+        for (int i = 0; i < received; i++) {
+            dispatch(shard, shard.batch_buffers[i].subbuf(0, shard.batch_sizes[i]), std::move(shard.batch_leases[i]), shard.batch_sources[i]);
+            shard.batch_buffers[i] = bco::Buffer {};
+            shard.batch_leases[i] = BufferPool::Lease {};
+        }
+        if (received < static_cast<int>(shard.batch_buffers.size())) {
+            break;
+        }
+    }
+}
+
+SessionHostImpl::PeerKey SessionHostImpl::peer_key(const sockaddr_storage& addr)
+{
+    PeerKey key;
+    if (addr.ss_family == AF_INET6) {
+        const auto& v6 = reinterpret_cast<const sockaddr_in6&>(addr);
+        ::memcpy(key.address.data(), &v6.sin6_addr, key.address.size());
+        key.port = ntohs(v6.sin6_port);
+    } else {
+        const auto& v4 = reinterpret_cast<const sockaddr_in&>(addr);
+        ::memcpy(key.address.data(), &v4.sin_addr, sizeof(v4.sin_addr));
+        key.port = ntohs(v4.sin_port);
+    }
+    return key;
+}
+
+bco::Routine SessionHostImpl::recv_loop(std::weak_ptr<SessionHostImpl> host, std::shared_ptr<Shard> shard)
+{
+    // First thing on the shard's context, so its thread stays on the core
+    // the kernel queues the shard's datagrams on.
+    if (shard->core >= 0) {
+        pin_current_thread(shard->core);
+    }
+    while (true) {
+        auto [buff, lease] = shard->recv_buffers.acquire();
+        auto [bytes, addr] = co_await shard->socket.recvfrom(buff);
+        // The read may complete after the host was stopped or destroyed.
+        auto that = host.lock();
+        if (that == nullptr || that->stop_) {
+            co_return;
+        }
+        if (bytes > 0) {
+            dispatch(*shard, buff.subbuf(0, bytes), std::move(lease), addr.to_storage());
+        }
+        // Whatever queued behind this datagram goes in batches, like a
+        // Transport reading its own socket.
+        if (shard->batch_io.enabled()) {
+            drain_socket(*shard);
+        }
+    }
+}
+
+bool enable_reuse_port(int fd)
+{
+#if defined(SO_REUSEPORT)
+    int on = 1;
+    return ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == 0;
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+size_t steering_index(const sockaddr_storage& source, size_t shard_count)
+{
+    if (shard_count <= 1) {
+        return 0;
+    }
+    // The last 32 bits of an IPv6 address, which is the IPv4 address of a
+    // mapped one, just as the kernel sees it.
+    if (source.ss_family == AF_INET6) {
+        const auto& v6 = reinterpret_cast<const sockaddr_in6&>(source);
+        const uint8_t* address = reinterpret_cast<const uint8_t*>(&v6.sin6_addr);
+        return steer(read_big_endian(address + 12), ntohs(v6.sin6_port), shard_count);
+    }
+    const auto& v4 = reinterpret_cast<const sockaddr_in&>(source);
+    return steer(ntohl(v4.sin_addr.s_addr), ntohs(v4.sin_port), shard_count);
+}
+
+bool attach_reuse_port_steering(int fd, size_t shard_count)
+{
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+    // Loads are relative to the network header, IPv4 without options.
+    constexpr uint32_t kIpVersion = SKF_NET_OFF;
+    constexpr uint32_t kIpv4Source = SKF_NET_OFF + 12;
+    constexpr uint32_t kIpv4SourcePort = SKF_NET_OFF + 20;
+    constexpr uint32_t kIpv6SourceLow = SKF_NET_OFF + 20;
+    constexpr uint32_t kIpv6SourcePort = SKF_NET_OFF + 40;
+    sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, kIpVersion),
+        BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 4),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 6, 4, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, kIpv4Source),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, kIpv4SourcePort),
+        BPF_JUMP(BPF_JMP | BPF_JA, 3, 0, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, kIpv6SourceLow),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, kIpv6SourcePort),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, kGoldenRatio),
+        BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, kSteeringShift),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, static_cast<uint32_t>(shard_count)),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+    sock_fprog program { static_cast<unsigned short>(std::size(code)), code };
+    return ::setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0;
+#else
+    (void)fd;
+    (void)shard_count;
+    return false;
+#endif
+}
+
+bool pin_current_thread(int core)
+{
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus) == 0;
+#elif defined(_WIN32)
+    return ::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR { 1 } << core) != 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
+} // namespace brtc
@@ -0,0 +1,110 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <bco/context.h>
+#include <brtc/interface.h>
+#include "common/buffer_pool.h"
+#include "transport/batch_io.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+namespace brtc {
+
+class Transport;
+
+// Owns one socket and context per shard. Every shard socket is bound to the
+// same address with SO_REUSEPORT, and the kernel is told to hand datagrams to
+// the shard steering_index() gives their source, so a session, its Transport
+// and everything built on it only ever run on the context of that shard.
+class SessionHostImpl : public std::enable_shared_from_this<SessionHostImpl> {
+public:
+    SessionHostImpl(std::vector<SessionHost::Shard>&& shards, const PathMtuConfig& path_mtu);
+    size_t shard_count() const;
+    size_t shard_of(const bco::net::Address& remote_addr) const;
+    TransportInfo transport_info(const bco::net::Address& remote_addr);
+    std::shared_ptr<bco::Context> context(const bco::net::Address& remote_addr) const;
+    void start();
+    // The shard loops end on their next wakeup. They only hold the host
+    // weakly, it goes away with the public SessionHost and the last Transport.
+    void stop();
+
+    // Called by a Transport created from transport_info(), from then on the
+    // datagrams of |remote_addr| are handed to it. Either may be called from
+    // any thread, the change is made on the shard context before it reads the
+    // next datagram. A Transport must be destroyed on that context, detach()
+    // then takes effect before its datagrams are looked up again.
+    void attach(const bco::net::Address& remote_addr, Transport* transport);
+    void detach(const bco::net::Address& remote_addr, Transport* transport);
+
+private:
+    struct PeerKey {
+        std::array<uint8_t, 16> address {};
+        uint16_t port = 0;
+        bool operator==(const PeerKey& other) const = default;
+    };
+    struct PeerKeyHash {
+        size_t operator()(const PeerKey& key) const;
+    };
+    struct SessionChange {
+        PeerKey key;
+        Transport* transport;
+        bool attach;
+    };
+    struct Shard {
+        Shard(const SessionHost::Shard& info, const PathMtuConfig& path_mtu);
+        AnyUdpSocket socket;
+        std::shared_ptr<bco::Context> context;
+        int core;
+        BufferPool recv_buffers;
+        BatchIo batch_io;
+        // Same scheme as Transport, an empty buffer needs a refill.
+        std::array<bco::Buffer, BatchIo::kMaxBatchSize> batch_buffers;
+        std::array<BufferPool::Lease, BatchIo::kMaxBatchSize> batch_leases;
+        std::array<int, BatchIo::kMaxBatchSize> batch_sizes {};
+        std::array<sockaddr_storage, BatchIo::kMaxBatchSize> batch_sources {};
+        // attach() and detach() queue here, the lock is only taken when
+        // |has_changes| says there is something to pick up.
+        std::mutex changes_mutex;
+        std::vector<SessionChange> changes;
+        std::atomic<bool> has_changes { false };
+        // Only read and written on |context|.
+        std::unordered_map<PeerKey, Transport*, PeerKeyHash> sessions;
+    };
+
+private:
+    static PeerKey peer_key(const sockaddr_storage& addr);
+    void queue_change(const bco::net::Address& remote_addr, Transport* transport, bool attach);
+    static void apply_changes(Shard& shard);
+    static void dispatch(Shard& shard, bco::Buffer datagram, BufferPool::Lease lease, const sockaddr_storage& source);
+    static void drain_socket(Shard& shard);
+    // Keeps |shard| alive for a read that is still pending once the host is
+    // gone.
+    static bco::Routine recv_loop(std::weak_ptr<SessionHostImpl> host, std::shared_ptr<Shard> shard);
+
+private:
+    std::vector<std::shared_ptr<Shard>> shards_;
+    PathMtuConfig path_mtu_;
+    std::atomic<bool> stop_ { false };
+};
+
+// Lets further sockets bind the address of |fd|, call before binding it.
+bool enable_reuse_port(int fd);
+// Shard of a datagram from |source|, the same function of the source address
+// and port the steering program computes in the kernel.
+size_t steering_index(const sockaddr_storage& source, size_t shard_count);
+// Steers the datagrams of the SO_REUSEPORT group |fd| belongs to with
+// steering_index(), the n-th socket bound to the address being shard n.
+// Linux only.
+bool attach_reuse_port_steering(int fd, size_t shard_count);
+bool pin_current_thread(int core);
+
+} // namespace brtc
@@ -1,34 +1,106 @@
+#include <algorithm>
 #include <bco/coroutine/cofunc.h>
 #include "transport.h"
 
 namespace brtc {
 
+namespace {
+// Never below a full ethernet frame, whatever the peer is configured with.
+constexpr size_t kMinRecvBufferSize = 1500;
+// Upper bound of batched reads per wakeup, so one busy socket can not starve
+// the other coroutines on the same context.
+constexpr size_t kMaxDrainRounds = 4;
+constexpr std::chrono::milliseconds kProbeInterval { 100 };
+} // namespace
+
+size_t Transport::recv_buffer_size(const PathMtuConfig& config)
+{
+    return std::max(kMinRecvBufferSize, datagram_size_ceiling(config)) + 1;
+}
+
 Transport::Transport(std::shared_ptr<bco::Context> ctx, const TransportInfo& info)
     : ctx_(ctx)
+    , host_(info.host)
     , remote_addr_(info.remote_addr)
     , socket_(info.socket)
-    , rtp_(new RtpTransport {std::bind(&Transport::send_packet, this, std::placeholders::_1)})
+    , rtp_(new RtpTransport {
+          std::bind(&Transport::send_packet, this, std::placeholders::_1),
+          std::bind(&Transport::send_packets, this, std::placeholders::_1) })
     , sctp_(new SctpTransport)
     , quic_(new QuicTransport)
+    , recv_buffers_(recv_buffer_size(info.path_mtu), info.host ? 0 : kRecvBufferPoolCapacity)
+    , batch_io_(socket_.fd())
+    , path_mtu_config_(info.path_mtu)
+    , max_datagram_size_(datagram_size_ceiling(info.path_mtu))
 {
-    ctx_->spawn(std::bind(&Transport::recv_loop, this));
+    if (path_mtu_config_.probe) {
+        path_mtu_prober_ = std::make_unique<PathMtuProber>(path_mtu_config_.max_datagram_size);
+        max_datagram_size_ = path_mtu_prober_->datagram_size();
+        // A host shares the socket between sessions and sets DF itself.
+        if (!host_) {
+            set_dont_fragment(socket_.fd());
+        }
+    }
+    if (host_) {
+        host_->attach(remote_addr_, this);
+    } else {
+        ctx_->spawn(std::bind(&Transport::recv_loop, this));
+    }
+    if (path_mtu_prober_) {
+        ctx_->spawn(std::bind(&Transport::probe_loop, this));
+    }
 }
 
 Transport::~Transport()
 {
-
+    if (host_) {
+        host_->detach(remote_addr_, this);
+    }
 }
 
-void Transport::set_socket(bco::net::UdpSocket<bco::net::Select> socket)
+void Transport::set_socket(AnyUdpSocket socket)
 {
     socket_ = socket;
+    batch_io_ = BatchIo { socket_.fd() };
+    if (path_mtu_prober_ && !host_) {
+        set_dont_fragment(socket_.fd());
+    }
 }
 
 void Transport::set_remote_address(bco::net::Address addr)
 {
+    if (host_) {
+        host_->detach(remote_addr_, this);
+        host_->attach(addr, this);
+    }
     remote_addr_ = addr;
 }
 
+BufferPool::Stats Transport::recv_buffer_stats() const
+{
+    return recv_buffers_.stats();
+}
+
+Transport::IoStats Transport::io_stats() const
+{
+    IoStats stats;
+    stats.datagrams_received = datagrams_received_;
+    stats.recv_calls = recv_calls_;
+    stats.datagrams_sent = datagrams_sent_;
+    stats.send_calls = send_calls_;
+    stats.datagrams_send_failed = datagrams_send_failed_;
+    stats.datagrams_truncated = datagrams_truncated_;
+    for (size_t i = 0; i < kDatagramTypeCount; i++) {
+        stats.datagrams_by_type[i] = datagrams_by_type_[i];
+    }
+    return stats;
+}
+
+size_t Transport::max_datagram_size() const
+{
+    return max_datagram_size_;
+}
+
 //bco::Func<bool> Transport::handshake(std::chrono::milliseconds timeout)
 //{
 //    auto result = co_await bco::run_with(bco::Timeout { timeout }, do_handshake());
@@ -44,6 +116,21 @@ bco::Task<RtpPacket> Transport::recv_rtp()
     return rtp_->recv_rtp_packet();
 }
 
+bco::Task<RtpPacket> Transport::recv_rtp(uint32_t ssrc)
+{
+    return rtp_->recv_rtp_packet(ssrc);
+}
+
+bool Transport::add_rtp_stream(uint32_t ssrc)
+{
+    return rtp_->add_rtp_stream(ssrc);
+}
+
+bool Transport::remove_rtp_stream(uint32_t ssrc)
+{
+    return rtp_->remove_rtp_stream(ssrc);
+}
+
 bco::Task<RtcpPacket> Transport::recv_rtcp()
 {
     return rtp_->recv_rtcp_packet();
@@ -52,16 +139,124 @@ bco::Task<RtcpPacket> Transport::recv_rtcp()
 bco::Routine Transport::recv_loop()
 {
     while (true) {
-        bco::Buffer buff { 1500 };
+        auto [buff, lease] = recv_buffers_.acquire();
         auto [bytes, addr] = co_await socket_.recvfrom(buff);
-        std::apply([&buff](auto&... sink) { (..., sink->on_recv_data(buff)); },
-            std::make_tuple(std::ref(rtp_), std::ref(sctp_), std::ref(quic_)));
+        recv_calls_++;
+        if (bytes > 0) {
+            on_recv_datagram(buff.subbuf(0, bytes), std::move(lease));
+        }
+        // The socket just became readable, pick up whatever queued behind
+        // this datagram before going back to the proactor.
+        if (batch_io_.enabled()) {
+            drain_socket();
+        }
+    }
+}
+
+bco::Routine Transport::probe_loop()
+{
+    // Acks come back through recv_loop on the same context.
+    while (true) {
+        const size_t probe_size = path_mtu_prober_->next_probe();
+        if (probe_size == 0) {
+            break;
+        }
+        send_packet(build_path_mtu_probe(probe_size));
+        co_await bco::sleep_for(kProbeInterval);
+    }
+}
+
+void Transport::drain_socket()
+{
+    for (size_t round = 0; round < kMaxDrainRounds; round++) {
+        for (size_t i = 0; i < batch_buffers_.size(); i++) {
+            if (batch_buffers_[i].size() == 0) {
+                std::tie(batch_buffers_[i], batch_leases_[i]) = recv_buffers_.acquire();
+            }
+        }
+        int received = batch_io_.recv(batch_buffers_, batch_sizes_);
+        recv_calls_++;
+        for (int i = 0; i < received; i++) {
+            on_recv_datagram(batch_buffers_[i].subbuf(0, batch_sizes_[i]), std::move(batch_leases_[i]));
+            batch_buffers_[i] = bco::Buffer {};
+            batch_leases_[i] = BufferPool::Lease {};
+        }
+        if (received < static_cast<int>(batch_buffers_.size())) {
+            break;
+        }
+    }
+}
+
+void Transport::on_recv_datagram(bco::Buffer datagram, BufferPool::Lease lease)
+{
+    datagrams_received_++;
+    if (datagram.size() >= recv_buffers_.block_size()) {
+        datagrams_truncated_++;
+        return;
+    }
+    const DatagramType type = classify_datagram(datagram);
+    datagrams_by_type_[static_cast<size_t>(type)]++;
+    switch (type) {
+    case DatagramType::Rtp:
+        rtp_->on_recv_rtp(std::move(datagram), std::move(lease));
+        break;
+    case DatagramType::Rtcp:
+        if (!on_path_mtu_message(datagram)) {
+            rtp_->on_recv_rtcp(std::move(datagram), std::move(lease));
+        }
+        break;
+    case DatagramType::Dtls:
+        // Data channels are SCTP over DTLS.
+        sctp_->on_recv_data(std::move(datagram), std::move(lease));
+        break;
+    case DatagramType::Quic:
+        quic_->on_recv_data(std::move(datagram), std::move(lease));
+        break;
+    default:
+        // No ICE yet, STUN is only counted.
+        break;
     }
 }
 
+bool Transport::on_path_mtu_message(const bco::Buffer& datagram)
+{
+    auto message = parse_path_mtu_message(datagram);
+    if (!message.has_value()) {
+        return false;
+    }
+    if (message->kind == PathMtuMessage::Kind::kProbe) {
+        send_packet(build_path_mtu_ack(message->size));
+    } else if (path_mtu_prober_) {
+        path_mtu_prober_->on_probe_acked(message->size);
+        max_datagram_size_ = path_mtu_prober_->datagram_size();
+    }
+    return true;
+}
+
 void Transport::send_packet(bco::Buffer packet)
 {
-    socket_.sendto(packet, remote_addr_);
+    send_calls_++;
+    if (socket_.sendto(packet, remote_addr_) < 0) {
+        datagrams_send_failed_++;
+    } else {
+        datagrams_sent_++;
+    }
+}
+
+void Transport::send_packets(std::span<const bco::Buffer> packets)
+{
+    size_t sent = 0;
+    if (batch_io_.enabled()) {
+        uint64_t syscalls = 0;
+        sent = std::max(batch_io_.send(packets, remote_addr_, syscalls), 0);
+        send_calls_ += syscalls;
+        datagrams_sent_ += sent;
+    }
+    // Whatever sendmmsg did not take, usually because the socket buffer is
+    // full, gets one more try on its own before it counts as dropped.
+    for (const auto& packet : packets.subspan(sent)) {
+        send_packet(packet);
+    }
 }
 
 //bco::Task<bool> Transport::do_handshake()
@@ -75,6 +270,11 @@ void Transport::send_rtp(RtpPacket packet)
     rtp_->send_packet(packet);
 }
 
+void Transport::send_rtp(std::span<const RtpPacket> packets)
+{
+    rtp_->send_packets(packets);
+}
+
 void Transport::send_rtcp(RtcpPacket packet)
 {
     rtp_->send_packet(packet);
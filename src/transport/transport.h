@@ -1,12 +1,17 @@
 #pragma once
 
 #include <cstdint>
+#include <array>
 #include <span>
 #include <bco/buffer.h>
 #include <bco/net/udp.h>
-#include <bco/net/proactor/select.h>
 #include <brtc/interface.h>
+#include "common/buffer_pool.h"
+#include "transport/batch_io.h"
+#include "transport/demux.h"
+#include "transport/path_mtu.h"
 #include "transport/rtp_transport.h"
+#include "transport/session_host.h"
 #include "transport/sctp_transport.h"
 #include "transport/quic_transport.h"
 #include "rtp/rtp.h"
@@ -14,37 +19,93 @@
 namespace brtc {
 
 class Transport {
+public:
+    struct IoStats {
+        uint64_t datagrams_received = 0;
+        uint64_t recv_calls = 0;
+        uint64_t datagrams_sent = 0;
+        uint64_t send_calls = 0;
+        // Datagrams the socket refused, dropped.
+        uint64_t datagrams_send_failed = 0;
+        // Datagrams larger than the receive buffers, dropped.
+        uint64_t datagrams_truncated = 0;
+        // Datagrams handed on, indexed by DatagramType.
+        std::array<uint64_t, kDatagramTypeCount> datagrams_by_type {};
+    };
+
+public:
+    // Enough to cover a full FrameAssembler plus the packets queued in front of it.
+    static constexpr size_t kRecvBufferPoolCapacity = 2048;
+    // One spare byte, a datagram that fills the whole buffer was cut short.
+    static size_t recv_buffer_size(const PathMtuConfig& config);
+
 public:
     Transport(std::shared_ptr<bco::Context> ctx, const TransportInfo& info);
     ~Transport();
 
-    void set_socket(bco::net::UdpSocket<bco::net::Select> socket);
+    void set_socket(AnyUdpSocket socket);
     void set_remote_address(bco::net::Address addr);
+    BufferPool::Stats recv_buffer_stats() const;
+    IoStats io_stats() const;
+    // Largest datagram the path is known to carry, grows while probing.
+    size_t max_datagram_size() const;
 
     //bco::Func<bool> handshake(std::chrono::milliseconds timeout);
 
     bco::Task<RtpPacket> recv_rtp();
+    bco::Task<RtpPacket> recv_rtp(uint32_t ssrc);
+    // See RtpTransport::add_rtp_stream(), call on |ctx|.
+    bool add_rtp_stream(uint32_t ssrc);
+    bool remove_rtp_stream(uint32_t ssrc);
     bco::Task<RtcpPacket> recv_rtcp();
     bco::Task<int> recv_sctp(bco::Buffer packet);
     bco::Task<int> recv_quic(bco::Buffer packet);
 
     void send_rtp(RtpPacket packet);
+    // Sends a burst of packets with as few syscalls as the platform allows.
+    void send_rtp(std::span<const RtpPacket> packets);
     void send_rtcp(RtcpPacket packet);
     void send_sctp(); // Ҫbco::Task
     void send_quic(); // Ҫbco::Task
 
 private:
+    friend class SessionHostImpl;
+
     bco::Routine recv_loop();
+    bco::Routine probe_loop();
+    void drain_socket();
+    void on_recv_datagram(bco::Buffer datagram, BufferPool::Lease lease);
+    bool on_path_mtu_message(const bco::Buffer& datagram);
     void send_packet(bco::Buffer packet);
+    void send_packets(std::span<const bco::Buffer> packets);
     //bco::Task<bool> do_handshake();
 
 private:
     std::shared_ptr<bco::Context> ctx_;
+    // Reads the shared socket of a SessionHost shard for us when set.
+    std::shared_ptr<SessionHostImpl> host_;
     bco::net::Address remote_addr_;
-    bco::net::UdpSocket<bco::net::Select> socket_;
+    AnyUdpSocket socket_;
     std::unique_ptr<RtpTransport> rtp_;
     std::unique_ptr<SctpTransport> sctp_;
     std::unique_ptr<QuicTransport> quic_;
+    BufferPool recv_buffers_;
+    BatchIo batch_io_;
+    // Spare pooled buffers for the next batched read, an empty buffer marks a
+    // slot that was handed off and needs a refill.
+    std::array<bco::Buffer, BatchIo::kMaxBatchSize> batch_buffers_;
+    std::array<BufferPool::Lease, BatchIo::kMaxBatchSize> batch_leases_;
+    std::array<int, BatchIo::kMaxBatchSize> batch_sizes_ {};
+    std::atomic<uint64_t> datagrams_received_ { 0 };
+    std::atomic<uint64_t> recv_calls_ { 0 };
+    std::atomic<uint64_t> datagrams_sent_ { 0 };
+    std::atomic<uint64_t> send_calls_ { 0 };
+    std::atomic<uint64_t> datagrams_send_failed_ { 0 };
+    std::atomic<uint64_t> datagrams_truncated_ { 0 };
+    std::array<std::atomic<uint64_t>, kDatagramTypeCount> datagrams_by_type_ {};
+    PathMtuConfig path_mtu_config_;
+    std::unique_ptr<PathMtuProber> path_mtu_prober_;
+    std::atomic<size_t> max_datagram_size_;
     std::atomic<bool> reading_ { false };
 };
 
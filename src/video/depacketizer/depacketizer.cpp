@@ -0,0 +1,24 @@
+#include <cassert>
+#include "video/depacketizer/depacketizer.h"
+#include "video/depacketizer/depacketizer_h264.h"
+
+namespace brtc {
+
+std::unique_ptr<Depacketizer> Depacketizer::create(VideoCodecType codec_type)
+{
+    switch (codec_type) {
+    case brtc::VideoCodecType::H264:
+        return std::make_unique<DepacketizerH264>();
+    case brtc::VideoCodecType::H265:
+        return nullptr;
+    case brtc::VideoCodecType::VP8:
+        return nullptr;
+    case brtc::VideoCodecType::VP9:
+        return nullptr;
+    default:
+        assert(false);
+    }
+    return nullptr;
+}
+
+} // namespace brtc
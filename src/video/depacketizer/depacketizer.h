@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "rtp/rtp.h"
+
+namespace brtc {
+
+// Receive side counterpart of Packetizer, turns RTP payloads back into what
+// the decoder takes.
+class Depacketizer {
+public:
+    virtual ~Depacketizer() { }
+    static std::unique_ptr<Depacketizer> create(VideoCodecType codec_type);
+    // Parses the payload of |packet| and sets its codec specific video
+    // header, false if the payload is malformed or uses an unsupported mode.
+    virtual bool parse(RtpPacket& packet) = 0;
+    // Appends the decoder input carried by a parsed |packet| to |slices|. The
+    // slices point into the payload or at constants, nothing is copied.
+    virtual void append_bitstream(const RtpPacket& packet, std::vector<std::span<const uint8_t>>& slices) const = 0;
+};
+
+} // namespace brtc
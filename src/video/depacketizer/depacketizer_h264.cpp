@@ -0,0 +1,164 @@
+#include <array>
+#include "video/depacketizer/depacketizer_h264.h"
+
+namespace brtc {
+
+namespace {
+constexpr size_t kNalHeaderSize = 1;
+constexpr size_t kFuAHeaderSize = 2;
+constexpr size_t kLengthFieldSize = 2;
+
+constexpr uint8_t kFNriMask = 0xE0;
+constexpr uint8_t kTypeMask = 0x1F;
+constexpr uint8_t kSBit = 0x80;
+constexpr uint8_t kEBit = 0x40;
+
+constexpr uint8_t kStartCode[kH264StartCodeLength] = { 0, 0, 0, 1 };
+
+// Every possible NALU header byte, so the one rebuilt for an FU-A can be
+// referenced like the start code instead of being written somewhere.
+constexpr std::array<uint8_t, 256> make_nalu_headers()
+{
+    std::array<uint8_t, 256> headers {};
+    for (size_t i = 0; i < headers.size(); i++) {
+        headers[i] = static_cast<uint8_t>(i);
+    }
+    return headers;
+}
+constexpr std::array<uint8_t, 256> kNaluHeaders = make_nalu_headers();
+
+// Received packets keep the payload in a single span of the datagram.
+std::span<const uint8_t> contiguous_payload(const RtpPacket& packet)
+{
+    auto spans = packet.payload().data();
+    if (spans.size() != 1) {
+        return {};
+    }
+    return spans.front();
+}
+
+uint16_t read_length(std::span<const uint8_t> data, size_t offset)
+{
+    return static_cast<uint16_t>(data[offset] << 8 | data[offset + 1]);
+}
+
+NaluInfo make_nalu_info(uint8_t type)
+{
+    NaluInfo info;
+    info.type = type;
+    info.sps_id = -1;
+    info.pps_id = -1;
+    return info;
+}
+
+bool is_key_nalu(uint8_t type)
+{
+    return type == H264NaluType::Idr || type == H264NaluType::Sps;
+}
+
+} // namespace
+
+bool DepacketizerH264::parse(RtpPacket& packet)
+{
+    const std::span<const uint8_t> payload = contiguous_payload(packet);
+    if (payload.empty()) {
+        return false;
+    }
+    RTPVideoHeaderH264 header {};
+    header.codec = VideoCodecType::H264;
+    header.packetization_mode = H264PacketizationMode::NonInterleaved;
+    // RFC 6184 5.1, the marker is set on the last packet of an access unit.
+    header.is_last_packet_in_frame = packet.marker();
+    header.frame_type = VideoFrameType::VideoFrameDelta;
+    const uint8_t type = payload[0] & kTypeMask;
+    if (type == H264NaluType::StapA) {
+        header.packetization_type = H264PacketizationTypes::kH264StapA;
+        size_t offset = kNalHeaderSize;
+        while (offset + kLengthFieldSize <= payload.size()) {
+            const size_t length = read_length(payload, offset);
+            offset += kLengthFieldSize;
+            if (length == 0 || offset + length > payload.size()) {
+                return false;
+            }
+            const uint8_t nalu_type = payload[offset] & kTypeMask;
+            header.nalus.push_back(make_nalu_info(nalu_type));
+            if (is_key_nalu(nalu_type)) {
+                header.frame_type = VideoFrameType::VideoFrameKey;
+            }
+            offset += length;
+        }
+        if (header.nalus.empty() || offset != payload.size()) {
+            return false;
+        }
+        header.nalu_type = static_cast<H264NaluType>(header.nalus[0].type);
+    } else if (type == H264NaluType::FuA) {
+        if (payload.size() <= kFuAHeaderSize) {
+            return false;
+        }
+        header.packetization_type = H264PacketizationTypes::kH264FuA;
+        const uint8_t original_type = payload[1] & kTypeMask;
+        header.nalu_type = static_cast<H264NaluType>(original_type);
+        header.has_last_fragement = (payload[1] & kEBit) != 0;
+        // Only the first fragment lists the NALU, like a STAP-A lists its own.
+        if (payload[1] & kSBit) {
+            header.nalus.push_back(make_nalu_info(original_type));
+        }
+        if (is_key_nalu(original_type)) {
+            header.frame_type = VideoFrameType::VideoFrameKey;
+        }
+    } else if (type > 0 && type < H264NaluType::StapA) {
+        header.packetization_type = H264PacketizationTypes::kH264SingleNalu;
+        header.nalu_type = static_cast<H264NaluType>(type);
+        header.nalus.push_back(make_nalu_info(type));
+        if (is_key_nalu(type)) {
+            header.frame_type = VideoFrameType::VideoFrameKey;
+        }
+    } else {
+        // STAP-B, MTAP and FU-B only exist in the interleaved mode.
+        return false;
+    }
+    packet.set_video_header(header);
+    return true;
+}
+
+void DepacketizerH264::append_bitstream(const RtpPacket& packet, std::vector<std::span<const uint8_t>>& slices) const
+{
+    append_annexb(packet, slices);
+}
+
+void DepacketizerH264::append_annexb(const RtpPacket& packet, std::vector<std::span<const uint8_t>>& slices)
+{
+    const std::span<const uint8_t> payload = contiguous_payload(packet);
+    if (payload.empty()) {
+        return;
+    }
+    const auto& header = packet.video_header<RTPVideoHeaderH264>();
+    switch (header.packetization_type) {
+    case H264PacketizationTypes::kH264SingleNalu:
+        slices.push_back(kStartCode);
+        slices.push_back(payload);
+        break;
+    case H264PacketizationTypes::kH264StapA: {
+        // Already validated by parse().
+        size_t offset = kNalHeaderSize;
+        while (offset + kLengthFieldSize <= payload.size()) {
+            const size_t length = read_length(payload, offset);
+            offset += kLengthFieldSize;
+            slices.push_back(kStartCode);
+            slices.push_back(payload.subspan(offset, length));
+            offset += length;
+        }
+        break;
+    }
+    case H264PacketizationTypes::kH264FuA:
+        if (!header.nalus.empty()) {
+            const uint8_t nalu_header = (payload[0] & kFNriMask) | (payload[1] & kTypeMask);
+            slices.push_back(kStartCode);
+            slices.push_back({ &kNaluHeaders[nalu_header], kNalHeaderSize });
+        }
+        slices.push_back(payload.subspan(kFuAHeaderSize));
+        break;
+    }
+}
+
+} // namespace brtc
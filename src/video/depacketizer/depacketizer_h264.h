@@ -0,0 +1,19 @@
+#pragma once
+#include "video/depacketizer/depacketizer.h"
+
+namespace brtc {
+
+// RFC 6184 single NAL unit, STAP-A and FU-A payloads, the non-interleaved
+// mode the packetizer produces.
+class DepacketizerH264 final : public Depacketizer {
+public:
+    bool parse(RtpPacket& packet) override;
+    void append_bitstream(const RtpPacket& packet, std::vector<std::span<const uint8_t>>& slices) const override;
+
+    // Annex-B for a packet parsed by parse(): a shared start code in front of
+    // every NALU, and for the first FU-A fragment the NALU header rebuilt
+    // from the FU indicator and FU header.
+    static void append_annexb(const RtpPacket& packet, std::vector<std::span<const uint8_t>>& slices);
+};
+
+} // namespace brtc
@@ -8,8 +8,11 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
+#include <cstring>
 #include <glog/logging.h>
 #include "common/time_utils.h"
+#include "video/depacketizer/depacketizer_h264.h"
 #include "video/frame_assembler/frame_assembler.h"
 
 namespace brtc {
@@ -25,6 +28,12 @@ void FrameAssembler::insert(RtpPacket rtp_packet)
     uint16_t seq_num = rtp_packet.sequence_number();
     size_t index = seq_num % buffer_.size();
 
+    if (last_assembled_seq_num_ && !webrtc::AheadOf(seq_num, *last_assembled_seq_num_)) {
+        // A duplicate or late packet of a frame that was assembled already,
+        // or given up on for a newer one.
+        return;
+    }
+
     if (!first_packet_received_) {
         first_seq_num_ = seq_num;
         first_packet_received_ = true;
@@ -38,19 +47,25 @@ void FrameAssembler::insert(RtpPacket rtp_packet)
         first_seq_num_ = seq_num;
     }
 
-    if (not buffer_[index].empty_payload()) {
+    if (buffer_[index].used() && last_assembled_seq_num_ && !webrtc::AheadOf(buffer_[index].seq_num, *last_assembled_seq_num_)) {
+        // Left over from a frame older than the last one assembled, it will
+        // never be assembled.
+        buffer_[index].packet.reset();
+    }
+
+    if (buffer_[index].used()) {
         // Duplicate packet, just delete the payload.
-        if (buffer_[index].sequence_number() == rtp_packet.sequence_number()) {
+        if (buffer_[index].seq_num == seq_num) {
             return;
         }
 
         // The packet buffer is full, try to expand the buffer.
-        while (expand_buffer() && !buffer_[seq_num % buffer_.size()].empty_payload()) {
+        while (expand_buffer() && buffer_[seq_num % buffer_.size()].used()) {
         }
         index = seq_num % buffer_.size();
 
         // Packet buffer is still full since we were unable to expand the buffer.
-        if (not buffer_[index].empty_payload()) {
+        if (buffer_[index].used()) {
             // Clear the buffer, delete payload, and return false to signal that a
             // new keyframe is needed.
             LOG(WARNING) << "Clear PacketBuffer and request key frame.";
@@ -69,223 +84,335 @@ void FrameAssembler::insert(RtpPacket rtp_packet)
         last_received_keyframe_rtp_timestamp_ = rtp_packet.timestamp();
     }
 
-    Packet packet { std::move(rtp_packet) };
-    packet.continuous = false;
-    buffer_[index] = std::move(packet);
+    const bool filled_gap = missing_packets_.is_missing(seq_num);
+    update_frame_record(rtp_packet);
+    buffer_[index].timestamp = rtp_packet.timestamp();
+    buffer_[index].seq_num = seq_num;
+    buffer_[index].packet = std::move(rtp_packet);
+
+    update_missing_packets(seq_num);
+
+    find_frames(seq_num, filled_gap);
+}
 
+void FrameAssembler::insert_padding(uint16_t seq_num)
+{
+    const bool filled_gap = missing_packets_.is_missing(seq_num);
     update_missing_packets(seq_num);
 
-    find_frames(seq_num);
+    // A frame right after the padding may be waiting for its boundary.
+    bool found = false;
+    const uint16_t next_seq_num = seq_num + 1;
+    const PacketSlot& next_slot = buffer_[next_seq_num % buffer_.size()];
+    if (next_slot.used() && next_slot.seq_num == next_seq_num) {
+        found = try_assemble_frame(next_slot.timestamp);
+    }
+
+    if (found || filled_gap) {
+        retry_blocked_frames();
+    }
 }
 
 std::optional<Frame> FrameAssembler::pop_assembled_frame()
 {
     if (assembled_frames_.empty())
         return std::nullopt;
-    auto& packets = assembled_frames_.front();
-    auto frame_data = std::make_shared<std::vector<uint8_t>>();
-    for (auto& packet : packets) {
-        auto payload_spans = packet.payload().data();
-        for (auto span : payload_spans) {
-            std::ranges::copy(span, std::back_inserter(*frame_data));
+    auto packets = std::make_shared<std::vector<RtpPacket>>(std::move(assembled_frames_.front()));
+    assembled_frames_.pop_front();
+    Frame frame {};
+    frame.type = Frame::UnderlyingType::kMemorySlices;
+    frame.timestamp = packets->front().timestamp();
+    frame.keyframe = packets->front().video_header<RTPVideoHeader>().frame_type == VideoFrameType::VideoFrameKey;
+    // H.264 payloads become Annex-B, a start code and the NALU per slice.
+    frame.slices.reserve(packets->size() * 2);
+    for (auto& packet : *packets) {
+        if (packet.video_header<RTPVideoHeader>().codec == VideoCodecType::H264) {
+            DepacketizerH264::append_annexb(packet, frame.slices);
+        } else {
+            for (auto span : packet.payload().data()) {
+                frame.slices.push_back(span);
+            }
         }
     }
-    assembled_frames_.pop_front();
+    for (auto slice : frame.slices) {
+        frame.length += static_cast<uint32_t>(slice.size());
+    }
+    frame._data_holder = std::move(packets);
+    return frame;
+}
+
+std::optional<Frame> FrameAssembler::pop_assembled_frame_contiguous()
+{
+    auto sliced_frame = pop_assembled_frame();
+    if (!sliced_frame)
+        return std::nullopt;
+    auto frame_data = std::make_shared<std::vector<uint8_t>>(sliced_frame->length);
+    uint8_t* dst = frame_data->data();
+    for (auto slice : sliced_frame->slices) {
+        ::memcpy(dst, slice.data(), slice.size());
+        dst += slice.size();
+    }
     Frame frame {};
     frame.type = Frame::UnderlyingType::kMemory;
+    frame.timestamp = sliced_frame->timestamp;
+    frame.keyframe = sliced_frame->keyframe;
     frame.data = frame_data->data();
-    frame._data_holder = frame_data;
+    frame.length = sliced_frame->length;
+    frame._data_holder = std::move(frame_data);
+    return frame;
+}
+
+std::unique_ptr<ReceivedFrame> FrameAssembler::pop_received_frame()
+{
+    if (assembled_frames_.empty())
+        return nullptr;
+    auto frame = std::make_unique<ReceivedFrame>();
+    const RtpPacket& first_packet = assembled_frames_.front().front();
+    const RtpPacket& last_packet = assembled_frames_.front().back();
+    // The first packet carries the frame type and resolution settled on by
+    // try_assemble_frame().
+    const auto& video_header = first_packet.video_header<RTPVideoHeader>();
+    frame->codec_type = video_header.codec;
+    frame->frame_type = video_header.frame_type;
+    frame->first_seq_num = first_packet.sequence_number();
+    frame->last_seq_num = last_packet.sequence_number();
+    switch (video_header.codec) {
+    case VideoCodecType::H264:
+        frame->video_header = first_packet.video_header<RTPVideoHeaderH264>();
+        break;
+    case VideoCodecType::H265:
+        frame->video_header = first_packet.video_header<RTPVideoHeaderH265>();
+        break;
+    case VideoCodecType::VP8:
+        frame->video_header = first_packet.video_header<RTPVideoHeaderVP8>();
+        break;
+    case VideoCodecType::VP9:
+        frame->video_header = first_packet.video_header<RTPVideoHeaderVP9>();
+        break;
+    default:
+        frame->video_header = video_header;
+        break;
+    }
+    const uint32_t width = video_header.width;
+    const uint32_t height = video_header.height;
+    static_cast<Frame&>(*frame) = std::move(*pop_assembled_frame());
+    frame->width = width;
+    frame->height = height;
     return frame;
 }
 
 void FrameAssembler::update_missing_packets(uint16_t seq_num)
 {
-    if (!newest_inserted_seq_num_)
-        newest_inserted_seq_num_ = seq_num;
-
-    const int kMaxPaddingAge = 1000;
-    if (webrtc::AheadOf(seq_num, *newest_inserted_seq_num_)) {
-        uint16_t old_seq_num = seq_num - kMaxPaddingAge;
-        auto erase_to = missing_packets_.lower_bound(old_seq_num);
-        missing_packets_.erase(missing_packets_.begin(), erase_to);
-
-        // Guard against inserting a large amount of missing packets if there is a
-        // jump in the sequence number.
-        if (webrtc::AheadOf(old_seq_num, *newest_inserted_seq_num_))
-            *newest_inserted_seq_num_ = old_seq_num;
-
-        ++*newest_inserted_seq_num_;
-        while (webrtc::AheadOf(seq_num, *newest_inserted_seq_num_)) {
-            missing_packets_.insert(*newest_inserted_seq_num_);
-            ++*newest_inserted_seq_num_;
+    missing_packets_.insert(seq_num);
+}
+
+void FrameAssembler::update_frame_record(const RtpPacket& packet)
+{
+    const uint16_t seq_num = packet.sequence_number();
+    const auto& video_header = packet.video_header<RTPVideoHeader>();
+    const bool is_h264 = video_header.codec == VideoCodecType::H264;
+    // An access unit starts with an AUD or with the SPS of a keyframe.
+    bool starts_frame = video_header.is_first_packet_in_frame;
+    if (is_h264) {
+        const auto& h264_header = packet.video_header<RTPVideoHeaderH264>();
+        if (!h264_header.nalus.empty() && (h264_header.nalus[0].type == H264NaluType::Aud || h264_header.nalus[0].type == H264NaluType::Sps)) {
+            starts_frame = true;
+        }
+    }
+
+    auto [it, inserted] = frame_records_.try_emplace(packet.timestamp());
+    FrameRecord& record = it->second;
+    if (inserted) {
+        record.first_seq_num = seq_num;
+        record.newest_seq_num = seq_num;
+        record.is_h264 = is_h264;
+        record.first_packet_starts_frame = starts_frame;
+    } else if (webrtc::AheadOf(record.first_seq_num, seq_num)) {
+        record.first_seq_num = seq_num;
+        record.first_packet_starts_frame = starts_frame;
+    } else if (webrtc::AheadOf(seq_num, record.newest_seq_num)) {
+        record.newest_seq_num = seq_num;
+    }
+    ++record.num_packets;
+
+    if (video_header.is_last_packet_in_frame) {
+        record.has_last_packet = true;
+        record.last_seq_num = seq_num;
+    }
+    if (video_header.width > 0 && video_header.height > 0 && (record.width < 0 || webrtc::AheadOf(record.resolution_seq_num, seq_num))) {
+        record.resolution_seq_num = seq_num;
+        record.width = video_header.width;
+        record.height = video_header.height;
+    }
+
+    // Identify H.264 keyframes by means of SPS, PPS, and IDR.
+    if (record.is_h264) {
+        const auto& h264_header = packet.video_header<RTPVideoHeaderH264>();
+        for (const NaluInfo& nalu : h264_header.nalus) {
+            if (nalu.type == H264NaluType::Sps) {
+                record.has_h264_sps = true;
+            } else if (nalu.type == H264NaluType::Pps) {
+                record.has_h264_pps = true;
+            } else if (nalu.type == H264NaluType::Idr) {
+                record.has_h264_idr = true;
+            }
         }
-    } else {
-        missing_packets_.erase(seq_num);
     }
 }
 
-bool FrameAssembler::potential_new_frame(uint16_t seq_num) const
+void FrameAssembler::find_frames(uint16_t seq_num, bool filled_gap)
 {
-    size_t index = seq_num % buffer_.size();
-    size_t prev_index = index > 0 ? index - 1 : buffer_.size() - 1;
-    const auto& entry = buffer_[index];
-    const auto& prev_entry = buffer_[prev_index];
+    const uint32_t timestamp = buffer_[seq_num % buffer_.size()].timestamp;
+    bool found = try_assemble_frame(timestamp);
+
+    // H.264 has no reliable first packet flag, a frame starts right after a
+    // packet of another frame. This packet may be that boundary.
+    const uint16_t next_seq_num = seq_num + 1;
+    const PacketSlot& next_slot = buffer_[next_seq_num % buffer_.size()];
+    if (next_slot.used() && next_slot.seq_num == next_seq_num && next_slot.timestamp != timestamp) {
+        found = try_assemble_frame(next_slot.timestamp) || found;
+    }
 
-    if (entry.empty_payload())
-        return false;
-    if (entry.sequence_number() != seq_num)
+    if (found || filled_gap) {
+        retry_blocked_frames();
+    }
+}
+
+bool FrameAssembler::try_assemble_frame(uint32_t timestamp)
+{
+    auto it = frame_records_.find(timestamp);
+    if (it == frame_records_.end()) {
         return false;
-    if (entry.video_header<RTPVideoHeader>().is_first_packet_in_frame)
-        return true;
-    if (prev_entry.empty_payload())
+    }
+    FrameRecord& record = it->second;
+
+    // Complete when the packets from the first to the last one are all there,
+    // all of them checked in O(1) from the counters of the record.
+    if (!record.has_last_packet || record.newest_seq_num != record.last_seq_num) {
         return false;
-    if (prev_entry.sequence_number() != static_cast<uint16_t>(entry.sequence_number() - 1))
+    }
+    const uint16_t start_seq_num = record.first_seq_num;
+    const uint16_t end_seq_num = record.last_seq_num + 1;
+    // Use uint16_t type to handle sequence number wrap around case.
+    const uint16_t num_packets = end_seq_num - start_seq_num;
+    if (record.num_packets != num_packets) {
         return false;
-    if (prev_entry.timestamp() != entry.timestamp())
+    }
+    // Without a marked first packet, an H.264 frame starts after the last
+    // packet of the previous one, which must not be missing.
+    if (!record.first_packet_starts_frame && (!record.is_h264 || missing_packets_.is_missing(start_seq_num - 1))) {
         return false;
-    if (prev_entry.continuous)
-        return true;
+    }
 
-    return false;
-}
+    bool is_keyframe = false;
+    if (record.is_h264) {
+        is_keyframe = (sps_pps_idr_is_h264_keyframe_ && record.has_h264_idr && record.has_h264_sps && record.has_h264_pps) || (!sps_pps_idr_is_h264_keyframe_ && record.has_h264_idr);
 
-void FrameAssembler::find_frames(uint16_t seq_num)
-{
-    //std::vector<RtpPacket> found_frames;
-    for (size_t i = 0; i < buffer_.size() && potential_new_frame(seq_num); ++i) {
-        size_t index = seq_num % buffer_.size();
-        buffer_[index].continuous = true;
-
-        // If all packets of the frame is continuous, find the first packet of the
-        // frame and add all packets of the frame to the returned packets.
-        if (buffer_[index].video_header<RTPVideoHeader>().is_last_packet_in_frame) {
-            uint16_t start_seq_num = seq_num;
-
-            // Find the start index by searching backward until the packet with
-            // the |frame_begin| flag is set.
-            size_t start_index = index;
-            size_t tested_packets = 0;
-            int64_t frame_timestamp = buffer_[start_index].sequence_number();
-
-            // Identify H.264 keyframes by means of SPS, PPS, and IDR.
-            bool is_h264 = buffer_[start_index].video_header<RTPVideoHeader>().codec == VideoCodecType::H264;
-            bool has_h264_sps = false;
-            bool has_h264_pps = false;
-            bool has_h264_idr = false;
-            bool is_h264_keyframe = false;
-            int idr_width = -1;
-            int idr_height = -1;
-            while (true) {
-                ++tested_packets;
-
-                if (!is_h264 && buffer_[start_index].video_header<RTPVideoHeader>().is_first_packet_in_frame)
-                    break;
-
-                if (is_h264) {
-                    const auto& h264_header = buffer_[start_index].video_header<RTPVideoHeaderH264>();
-                    //if (!h264_header || h264_header.nalus_length >= kMaxNalusPerPacket)
-                    if (h264_header.nalus_length >= kMaxNalusPerPacket)
-                        return; //return found_frames;
-
-                    for (size_t j = 0; j < h264_header.nalus_length; ++j) {
-                        if (h264_header.nalus[j].type == H264NaluType::Sps) {
-                            has_h264_sps = true;
-                        } else if (h264_header.nalus[j].type == H264NaluType::Pps) {
-                            has_h264_pps = true;
-                        } else if (h264_header.nalus[j].type == H264NaluType::Idr) {
-                            has_h264_idr = true;
-                        }
-                    }
-                    if ((sps_pps_idr_is_h264_keyframe_ && has_h264_idr && has_h264_sps && has_h264_pps) || (!sps_pps_idr_is_h264_keyframe_ && has_h264_idr)) {
-                        is_h264_keyframe = true;
-                        // Store the resolution of key frame which is the packet with
-                        // smallest index and valid resolution; typically its IDR or SPS
-                        // packet; there may be packet preceeding this packet, IDR's
-                        // resolution will be applied to them.
-                        if (buffer_[start_index].video_header<RTPVideoHeader>().width > 0 && buffer_[start_index].video_header<RTPVideoHeader>().height > 0) {
-                            idr_width = buffer_[start_index].video_header<RTPVideoHeader>().width;
-                            idr_height = buffer_[start_index].video_header<RTPVideoHeader>().height;
-                        }
-                    }
-                }
-
-                if (tested_packets == buffer_.size())
-                    break;
-
-                start_index = start_index > 0 ? start_index - 1 : buffer_.size() - 1;
-
-                // In the case of H264 we don't have a frame_begin bit (yes,
-                // |frame_begin| might be set to true but that is a lie). So instead
-                // we traverese backwards as long as we have a previous packet and
-                // the timestamp of that packet is the same as this one. This may cause
-                // the PacketBuffer to hand out incomplete frames.
-                // See: https://bugs.chromium.org/p/webrtc/issues/detail?id=7106
-                if (is_h264 && (buffer_[start_index].empty_payload() || buffer_[start_index].timestamp() != frame_timestamp)) {
-                    break;
-                }
-
-                --start_seq_num;
+        // If this is not a keyframe, make sure there are no gaps in the packet
+        // sequence numbers up until this point.
+        if (!is_keyframe && missing_packets_.any_missing_up_to(start_seq_num)) {
+            if (!record.blocked) {
+                record.blocked = true;
+                block_frame(start_seq_num, timestamp);
             }
+            return false;
+        }
 
-            if (is_h264) {
-                // Warn if this is an unsafe frame.
-                if (has_h264_idr && (!has_h264_sps || !has_h264_pps)) {
-                    LOG(WARNING)
-                        << "Received H.264-IDR frame "
-                           "(SPS: "
-                        << has_h264_sps << ", PPS: " << has_h264_pps << "). Treating as "
-                        << (sps_pps_idr_is_h264_keyframe_ ? "delta" : "key")
-                        << " frame since WebRTC-SpsPpsIdrIsH264Keyframe is "
-                        << (sps_pps_idr_is_h264_keyframe_ ? "enabled." : "disabled");
-                }
-
-                // Now that we have decided whether to treat this frame as a key frame
-                // or delta frame in the frame buffer, we update the field that
-                // determines if the RtpFrameObject is a key frame or delta frame.
-                const size_t first_packet_index = start_seq_num % buffer_.size();
-                if (is_h264_keyframe) {
-                    buffer_[first_packet_index].video_header<RTPVideoHeader>().frame_type = VideoFrameType::VideoFrameKey;
-                    if (idr_width > 0 && idr_height > 0) {
-                        // IDR frame was finalized and we have the correct resolution for
-                        // IDR; update first packet to have same resolution as IDR.
-                        buffer_[first_packet_index].video_header<RTPVideoHeader>().width = idr_width;
-                        buffer_[first_packet_index].video_header<RTPVideoHeader>().height = idr_height;
-                    }
-                } else {
-                    buffer_[first_packet_index].video_header<RTPVideoHeader>().frame_type = VideoFrameType::VideoFrameDelta;
-                }
-
-                // If this is not a keyframe, make sure there are no gaps in the packet
-                // sequence numbers up until this point.
-                if (!is_h264_keyframe && missing_packets_.upper_bound(start_seq_num) != missing_packets_.begin()) {
-                    return; //return found_frames;
-                }
-            }
+        // Warn if this is an unsafe frame.
+        if (record.has_h264_idr && (!record.has_h264_sps || !record.has_h264_pps)) {
+            LOG(WARNING)
+                << "Received H.264-IDR frame "
+                   "(SPS: "
+                << record.has_h264_sps << ", PPS: " << record.has_h264_pps << "). Treating as "
+                << (sps_pps_idr_is_h264_keyframe_ ? "delta" : "key")
+                << " frame since WebRTC-SpsPpsIdrIsH264Keyframe is "
+                << (sps_pps_idr_is_h264_keyframe_ ? "enabled." : "disabled");
+        }
 
-            const uint16_t end_seq_num = seq_num + 1;
-            // Use uint16_t type to handle sequence number wrap around case.
-            uint16_t num_packets = end_seq_num - start_seq_num;
-            std::vector<RtpPacket> found_frames;
-            found_frames.reserve(found_frames.size() + num_packets);
-            for (uint16_t i = start_seq_num; i != end_seq_num; ++i) {
-                RtpPacket& packet = buffer_[i % buffer_.size()];
-                assert(i == packet.sequence_number());
-                // Ensure frame boundary flags are properly set.
-                packet.video_header<RTPVideoHeader>().is_first_packet_in_frame = (i == start_seq_num);
-                packet.video_header<RTPVideoHeader>().is_last_packet_in_frame = (i == seq_num);
-                found_frames.push_back(std::move(packet));
-            }
-            if (not found_frames.empty()) {
-                assembled_frames_.push_back(std::move(found_frames));
+        // Now that we have decided whether to treat this frame as a key frame
+        // or delta frame in the frame buffer, we update the field that
+        // determines if the RtpFrameObject is a key frame or delta frame.
+        auto& first_video_header = buffer_[start_seq_num % buffer_.size()].packet->video_header<RTPVideoHeader>();
+        if (is_keyframe) {
+            first_video_header.frame_type = VideoFrameType::VideoFrameKey;
+            if (record.width > 0 && record.height > 0) {
+                // IDR frame was finalized and we have the correct resolution for
+                // IDR; update first packet to have same resolution as IDR.
+                first_video_header.width = record.width;
+                first_video_header.height = record.height;
             }
+        } else {
+            first_video_header.frame_type = VideoFrameType::VideoFrameDelta;
+        }
+    } else {
+        is_keyframe = buffer_[start_seq_num % buffer_.size()].packet->video_header<RTPVideoHeader>().frame_type == VideoFrameType::VideoFrameKey;
+    }
+
+    const uint16_t last_seq_num = record.last_seq_num;
+    std::vector<RtpPacket> found_frames;
+    found_frames.reserve(num_packets);
+    for (uint16_t i = start_seq_num; i != end_seq_num; ++i) {
+        PacketSlot& slot = buffer_[i % buffer_.size()];
+        assert(slot.used() && i == slot.seq_num);
+        // Ensure frame boundary flags are properly set.
+        slot.packet->video_header<RTPVideoHeader>().is_first_packet_in_frame = (i == start_seq_num);
+        slot.packet->video_header<RTPVideoHeader>().is_last_packet_in_frame = (i == last_seq_num);
+        found_frames.push_back(std::move(*slot.packet));
+        slot.packet.reset();
+    }
+    assembled_frames_.push_back(std::move(found_frames));
+
+    if (record.blocked) {
+        std::erase_if(blocked_frames_, [timestamp](const BlockedFrame& frame) { return frame.timestamp == timestamp; });
+    }
+    frame_records_.erase(it);
+    missing_packets_.clear_up_to(last_seq_num);
+    if (!last_assembled_seq_num_ || webrtc::AheadOf(last_seq_num, *last_assembled_seq_num_)) {
+        last_assembled_seq_num_ = last_seq_num;
+    }
+    // Packets before this frame are ignored from now on, the frames they
+    // belong to can never complete.
+    drop_frame_records_before(start_seq_num);
+    return true;
+}
 
-            missing_packets_.erase(missing_packets_.begin(),
-                missing_packets_.upper_bound(seq_num));
+void FrameAssembler::block_frame(uint16_t first_seq_num, uint32_t timestamp)
+{
+    // Frames usually complete in order, the right place is near the back.
+    auto it = blocked_frames_.end();
+    while (it != blocked_frames_.begin() && webrtc::AheadOf(std::prev(it)->first_seq_num, first_seq_num)) {
+        --it;
+    }
+    blocked_frames_.insert(it, BlockedFrame { first_seq_num, timestamp });
+}
+
+void FrameAssembler::retry_blocked_frames()
+{
+    // A blocked frame waits for every packet before it, so blocked frames
+    // unblock oldest first and the oldest one still waiting holds back the
+    // rest. Each retry either assembles a frame or ends the loop.
+    while (!blocked_frames_.empty()) {
+        const uint32_t timestamp = blocked_frames_.front().timestamp;
+        if (!frame_records_.contains(timestamp)) {
+            blocked_frames_.pop_front();
+            continue;
+        }
+        if (!try_assemble_frame(timestamp)) {
+            break;
         }
-        ++seq_num;
     }
 }
 
+void FrameAssembler::drop_frame_records_before(uint16_t seq_num)
+{
+    std::erase_if(frame_records_, [seq_num](const auto& entry) {
+        return webrtc::AheadOf(seq_num, entry.second.newest_seq_num);
+    });
+    std::erase_if(blocked_frames_, [this](const BlockedFrame& frame) {
+        return !frame_records_.contains(frame.timestamp);
+    });
+}
+
 bool FrameAssembler::expand_buffer()
 {
     if (buffer_.size() == max_size_) {
@@ -295,10 +422,10 @@ bool FrameAssembler::expand_buffer()
     }
 
     size_t new_size = std::min(max_size_, 2 * buffer_.size());
-    std::vector<Packet> new_buffer(new_size);
+    std::vector<PacketSlot> new_buffer(new_size);
     for (auto& entry : buffer_) {
-        if (not entry.empty_payload()) {
-            new_buffer[entry.sequence_number() % new_size] = entry;
+        if (entry.used()) {
+            new_buffer[entry.seq_num % new_size] = std::move(entry);
         }
     }
     buffer_ = std::move(new_buffer);
@@ -309,15 +436,17 @@ bool FrameAssembler::expand_buffer()
 void FrameAssembler::clear_internal()
 {
     for (auto& entry : buffer_) {
-        entry = RtpPacket {};
+        entry.packet.reset();
     }
 
     first_packet_received_ = false;
     is_cleared_to_first_seq_num_ = false;
     last_received_packet_ms_.reset();
     last_received_keyframe_packet_ms_.reset();
-    newest_inserted_seq_num_.reset();
     missing_packets_.clear();
+    frame_records_.clear();
+    blocked_frames_.clear();
+    last_assembled_seq_num_.reset();
 }
 
 } // namespace brtc
@@ -1,34 +1,79 @@
 #pragma once
+#include <memory>
 #include <optional>
-#include <set>
 #include <deque>
+#include <unordered_map>
 #include <brtc/frame.h>
 #include "common/sequence_number_util.h"
 #include "rtp/rtp.h"
+#include "video/frame_assembler/missing_packet_tracker.h"
 
 namespace brtc {
 
 class FrameAssembler {
 private:
-    class Packet : public RtpPacket {
-    public:
-        Packet() = default;
-        Packet(RtpPacket&& rtp_packet)
-            : RtpPacket { std::move(rtp_packet) }
-        {
-        }
-        bool continuous = false;
+    // One entry of the packet ring. The fields needed to place and match
+    // packets are kept inline, the packet itself is only constructed while
+    // the slot is in use so empty slots cost no allocation.
+    struct PacketSlot {
+        bool used() const { return packet.has_value(); }
+
+        uint32_t timestamp = 0;
+        uint16_t seq_num = 0;
+        std::optional<RtpPacket> packet;
+    };
+
+    // What is known about a frame so far, updated as its packets arrive so
+    // that completion does not need to walk the packet buffer.
+    struct BlockedFrame {
+        uint16_t first_seq_num;
+        uint32_t timestamp;
+    };
+
+    struct FrameRecord {
+        uint16_t first_seq_num = 0;
+        uint16_t newest_seq_num = 0;
+        uint16_t last_seq_num = 0;
+        uint16_t num_packets = 0;
+        // The oldest packet so far is known to begin the frame.
+        bool first_packet_starts_frame = false;
+        bool has_last_packet = false;
+        // Complete, but waiting in |blocked_frames_|.
+        bool blocked = false;
+        bool is_h264 = false;
+        bool has_h264_sps = false;
+        bool has_h264_pps = false;
+        bool has_h264_idr = false;
+        // Resolution of the oldest packet that has one.
+        uint16_t resolution_seq_num = 0;
+        int width = -1;
+        int height = -1;
     };
 
 public:
     FrameAssembler(size_t start_size, size_t max_size);
     void insert(RtpPacket packet);
+    // A packet without payload, it only takes its sequence number so frames
+    // after it are not held back waiting for it.
+    void insert_padding(uint16_t seq_num);
+    // Hands out the payload slices of the assembled packets without copying,
+    // the packets are kept alive by Frame::_data_holder.
     std::optional<Frame> pop_assembled_frame();
+    // One-copy fallback for consumers that need contiguous memory.
+    std::optional<Frame> pop_assembled_frame_contiguous();
+    // The sliced frame plus what the reference finder needs to know about
+    // it, taken from the packets it was assembled from.
+    std::unique_ptr<ReceivedFrame> pop_received_frame();
 
 private:
+
     void update_missing_packets(uint16_t seq_num);
-    bool potential_new_frame(uint16_t seq_num) const;
-    void find_frames(uint16_t seq_num);
+    void update_frame_record(const RtpPacket& packet);
+    void find_frames(uint16_t seq_num, bool filled_gap);
+    bool try_assemble_frame(uint32_t timestamp);
+    void block_frame(uint16_t first_seq_num, uint32_t timestamp);
+    void retry_blocked_frames();
+    void drop_frame_records_before(uint16_t seq_num);
     bool expand_buffer();
     void clear_internal();
 
@@ -38,12 +83,19 @@ private:
     uint16_t first_seq_num_ = 0;
     bool is_cleared_to_first_seq_num_ = false;
     bool sps_pps_idr_is_h264_keyframe_ = false;
-    std::optional<uint16_t> newest_inserted_seq_num_;
-    std::set<uint16_t, webrtc::DescendingSeqNumComp<uint16_t>> missing_packets_;
+    MissingPacketTracker missing_packets_;
     std::optional<int64_t> last_received_packet_ms_;
     std::optional<uint32_t> last_received_keyframe_rtp_timestamp_;
     std::optional<int64_t> last_received_keyframe_packet_ms_;
-    std::vector<Packet> buffer_;
+    std::vector<PacketSlot> buffer_;
+    // Frames that have not been assembled yet, keyed by RTP timestamp.
+    std::unordered_map<uint32_t, FrameRecord> frame_records_;
+    // Complete delta frames waiting for a gap before them to be filled,
+    // oldest first.
+    std::deque<BlockedFrame> blocked_frames_;
+    // Last packet of the newest frame assembled, nothing up to it is needed
+    // any more.
+    std::optional<uint16_t> last_assembled_seq_num_;
     std::deque<std::vector<RtpPacket>> assembled_frames_;
     const size_t max_size_; //캯
 };
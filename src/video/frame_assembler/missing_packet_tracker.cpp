@@ -0,0 +1,109 @@
+#include <algorithm>
+#include "common/sequence_number_util.h"
+#include "video/frame_assembler/missing_packet_tracker.h"
+
+namespace brtc {
+
+void MissingPacketTracker::insert(uint16_t seq_num)
+{
+    if (!newest_seq_num_) {
+        newest_seq_num_ = seq_num;
+    }
+    if (webrtc::AheadOf(seq_num, *newest_seq_num_)) {
+        const uint16_t old_seq_num = seq_num - kMaxPaddingAge;
+        if (webrtc::AheadOf(old_seq_num, *newest_seq_num_)) {
+            // Guard against marking a large amount of missing packets if there
+            // is a jump in the sequence number, everything known is too old.
+            bits_.fill(0);
+            newest_seq_num_ = old_seq_num;
+        } else {
+            assign(window_begin(), count_up_to(old_seq_num - 1), false);
+        }
+        const uint16_t first_missing = *newest_seq_num_ + 1;
+        assign(first_missing, static_cast<uint16_t>(seq_num - first_missing), true);
+        // The slot of |seq_num| may still hold a bit from kWindowSize ago.
+        assign(seq_num, 1, false);
+        newest_seq_num_ = seq_num;
+    } else if (count_up_to(seq_num) > 0) {
+        assign(seq_num, 1, false);
+    }
+}
+
+bool MissingPacketTracker::is_missing(uint16_t seq_num) const
+{
+    if (!newest_seq_num_ || webrtc::AheadOf(seq_num, *newest_seq_num_) || count_up_to(seq_num) == 0) {
+        return false;
+    }
+    return any(seq_num, 1);
+}
+
+bool MissingPacketTracker::any_missing_up_to(uint16_t seq_num) const
+{
+    if (!newest_seq_num_) {
+        return false;
+    }
+    return any(window_begin(), count_up_to(seq_num));
+}
+
+void MissingPacketTracker::clear_up_to(uint16_t seq_num)
+{
+    if (!newest_seq_num_) {
+        return;
+    }
+    assign(window_begin(), count_up_to(seq_num), false);
+}
+
+void MissingPacketTracker::clear()
+{
+    newest_seq_num_.reset();
+    bits_.fill(0);
+}
+
+uint16_t MissingPacketTracker::window_begin() const
+{
+    return *newest_seq_num_ - static_cast<uint16_t>(kWindowSize - 1);
+}
+
+size_t MissingPacketTracker::count_up_to(uint16_t seq_num) const
+{
+    if (webrtc::AheadOf(seq_num, *newest_seq_num_)) {
+        return kWindowSize;
+    }
+    const size_t count = static_cast<uint16_t>(seq_num - window_begin()) + 1;
+    return count <= kWindowSize ? count : 0;
+}
+
+void MissingPacketTracker::assign(uint16_t first, size_t count, bool missing)
+{
+    size_t pos = first % kWindowSize;
+    while (count > 0) {
+        const size_t bit = pos % kBitsPerWord;
+        const size_t n = std::min(count, kBitsPerWord - bit);
+        const uint64_t mask = (n == kBitsPerWord ? ~uint64_t { 0 } : (uint64_t { 1 } << n) - 1) << bit;
+        if (missing) {
+            bits_[pos / kBitsPerWord] |= mask;
+        } else {
+            bits_[pos / kBitsPerWord] &= ~mask;
+        }
+        pos = (pos + n) % kWindowSize;
+        count -= n;
+    }
+}
+
+bool MissingPacketTracker::any(uint16_t first, size_t count) const
+{
+    size_t pos = first % kWindowSize;
+    while (count > 0) {
+        const size_t bit = pos % kBitsPerWord;
+        const size_t n = std::min(count, kBitsPerWord - bit);
+        const uint64_t mask = (n == kBitsPerWord ? ~uint64_t { 0 } : (uint64_t { 1 } << n) - 1) << bit;
+        if (bits_[pos / kBitsPerWord] & mask) {
+            return true;
+        }
+        pos = (pos + n) % kWindowSize;
+        count -= n;
+    }
+    return false;
+}
+
+} // namespace brtc
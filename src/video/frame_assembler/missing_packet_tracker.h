@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <optional>
+
+namespace brtc {
+
+// Remembers which of the last kWindowSize RTP sequence numbers are missing,
+// one bit per sequence number in a ring indexed by the sequence number.
+// Marking, clearing and "is anything missing before X" are word level
+// operations, a burst loss costs a few bit masks instead of a node per packet.
+class MissingPacketTracker {
+public:
+    // Records |seq_num| as received. When it is the newest so far, the
+    // sequence numbers skipped since the previous newest become missing.
+    void insert(uint16_t seq_num);
+    bool is_missing(uint16_t seq_num) const;
+    // Whether a packet at or before |seq_num| is missing.
+    bool any_missing_up_to(uint16_t seq_num) const;
+    // Forgets the missing packets at or before |seq_num|.
+    void clear_up_to(uint16_t seq_num);
+    void clear();
+
+private:
+    static constexpr size_t kWindowSize = 1024;
+    static constexpr size_t kBitsPerWord = 64;
+    // Missing packets older than this are forgotten as new packets come in.
+    static constexpr uint16_t kMaxPaddingAge = 1000;
+
+    uint16_t window_begin() const;
+    // Number of sequence numbers from the start of the window up to and
+    // including |seq_num|, 0 if |seq_num| is older than the window.
+    size_t count_up_to(uint16_t seq_num) const;
+    void assign(uint16_t first, size_t count, bool missing);
+    bool any(uint16_t first, size_t count) const;
+
+private:
+    std::optional<uint16_t> newest_seq_num_;
+    std::array<uint64_t, kWindowSize / kBitsPerWord> bits_ {};
+};
+
+} // namespace brtc
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cassert>
 #include <glog/logging.h>
 #include "common/sequence_number_util.h"
 #include "common/time_utils.h"
@@ -7,6 +9,10 @@ namespace {
 // Max number of frames the buffer will hold.
 constexpr size_t kMaxFramesBuffered = 800;
 
+// Number of slots in the frame table, a power of two above
+// kMaxFramesBuffered. Frame ids held at the same time must span less than this.
+constexpr size_t kFrameSlots = 1024;
+
 // Max number of decoded frame info that will be saved.
 constexpr int kMaxFramesHistory = 1 << 13;
 
@@ -19,9 +25,22 @@ constexpr int64_t kLogNonDecodedIntervalMs = 5000;
 
 namespace brtc {
 FrameBuffer::FrameBuffer(size_t decoded_history_size)
-    : decoded_frames_history_(decoded_history_size)
+    : frames_(kFrameSlots)
+    , frames_mask_(kFrameSlots - 1)
+    , decoded_frames_history_(decoded_history_size)
+{
+}
+
+void FrameBuffer::FrameInfo::reset(int64_t frame_id)
 {
+    id = frame_id;
+    dependent_frames.clear();
+    num_missing_continuous = 0;
+    num_missing_decodable = 0;
+    continuous = false;
+    frame.reset();
 }
+
 void FrameBuffer::insert(ReceivedFrame frame)
 {
     //MutexLock lock(&mutex_);
@@ -35,12 +54,16 @@ void FrameBuffer::insert(ReceivedFrame frame)
         return;
     }
 
-    if (frames_.size() >= kMaxFramesBuffered) {
+    if (num_frames_ >= kMaxFramesBuffered || !fits_window(frame)) {
         if (frame.frame_type == VideoFrameType::VideoFrameKey) {
             LOG(WARNING) << "Inserting keyframe " << frame.id
                                 << " but buffer is full, clearing"
                                    " buffer and inserting the frame.";
             clear_frames_and_history();
+            if (!fits_window(frame)) {
+                LOG(WARNING) << "Keyframe " << frame.id << " references frames too old to be buffered, dropping frame.";
+                return;
+            }
         } else {
             LOG(WARNING) << "Frame " << frame.id
                                 << " could not be inserted due to the frame "
@@ -72,18 +95,14 @@ void FrameBuffer::insert(ReceivedFrame frame)
         }
     }
 
-    // Test if inserting this frame would cause the order of the frames to become
-    // ambiguous (covering more than half the interval of 2^16). This can happen
-    // when the frame id make large jumps mid stream.
-    if (!frames_.empty() && frame.id < frames_.begin()->first && frames_.rbegin()->first < frame.id) {
-        LOG(WARNING) << "A jump in frame id was detected, clearing buffer.";
-        clear_frames_and_history();
-        last_continuous_frame_id = -1;
+    FrameInfo* created = find_or_create(frame.id);
+    if (created == nullptr) {
+        LOG(WARNING) << "Frame " << frame.id << " collides with a buffered frame, dropping frame.";
+        return;
     }
+    auto& info = *created;
 
-    auto info = frames_.emplace(frame.id, FrameInfo()).first;
-
-    if (info->second.frame) {
+    if (info.frame) {
         //return last_continuous_frame_id;
         return;
     }
@@ -97,15 +116,49 @@ void FrameBuffer::insert(ReceivedFrame frame)
     //    timing_->IncomingTimestamp(frame.timestamp, frame->ReceivedTime());
 
 
-    info->second.frame = std::move(frame);
+    info.frame = std::move(frame);
+
+    if (info.num_missing_continuous == 0) {
+        info.continuous = true;
+        propagate_continuity(info);
+        last_continuous_frame_id = *last_continuous_frame_;
+    }
 }
 
 std::optional<ReceivedFrame> FrameBuffer::pop_decodable_frame()
 {
-    return std::optional<ReceivedFrame>();
+    if (num_frames_ == 0 || !last_continuous_frame_) {
+        return std::nullopt;
+    }
+    // There is no render timing yet, frames are handed to the decoder as soon
+    // as they become decodable, in frame id order.
+    auto last_decoded_frame_timestamp = decoded_frames_history_.GetLastDecodedFrameTimestamp();
+    while (!decodable_frames_.empty()) {
+        const int64_t frame_id = decodable_frames_.top();
+        decodable_frames_.pop();
+        FrameInfo* info = find(frame_id);
+        if (info == nullptr || !info->frame) {
+            continue;
+        }
+        if (last_decoded_frame_timestamp && webrtc::AheadOf(*last_decoded_frame_timestamp, info->frame->timestamp)) {
+            LOG(WARNING) << "Frame " << frame_id << " has an older timestamp than the last decoded frame, skipping.";
+            continue;
+        }
+        propagate_decodability(*info);
+        decoded_frames_history_.InsertDecoded(frame_id, info->frame->timestamp);
+        ReceivedFrame frame = std::move(*info->frame);
+        erase_frames_before(frame_id + 1);
+        return frame;
+    }
+    return std::nullopt;
+}
+
+size_t FrameBuffer::size() const
+{
+    return num_frames_;
 }
 
-bool FrameBuffer::valid_references(ReceivedFrame frame)
+bool FrameBuffer::valid_references(const ReceivedFrame& frame)
 {
     for (size_t i = 0; i < frame.num_references; ++i) {
         if (frame.references[i] >= frame.id)
@@ -122,16 +175,21 @@ bool FrameBuffer::valid_references(ReceivedFrame frame)
 
 void FrameBuffer::clear_frames_and_history()
 {
-    frames_.clear();
+    if (num_frames_ > 0) {
+        for (auto& info : frames_) {
+            info.reset(kNoFrame);
+        }
+    }
+    num_frames_ = 0;
     last_continuous_frame_.reset();
-    frames_to_decode_.clear();
+    decodable_frames_ = {};
     decoded_frames_history_.Clear();
 }
 
-bool FrameBuffer::update_frame_info_with_incoming_frame(const ReceivedFrame& frame, FrameMap::iterator info)
+bool FrameBuffer::update_frame_info_with_incoming_frame(const ReceivedFrame& frame, FrameInfo& info)
 {
     auto last_decoded_frame = decoded_frames_history_.GetLastDecodedFrameId();
-    assert(!last_decoded_frame || *last_decoded_frame < info->first);
+    assert(!last_decoded_frame || *last_decoded_frame < info.id);
 
     // In this function we determine how many missing dependencies this |frame|
     // has to become continuous/decodable. If a frame that this |frame| depend
@@ -165,24 +223,131 @@ bool FrameBuffer::update_frame_info_with_incoming_frame(const ReceivedFrame& fra
                 return false;
             }
         } else {
-            auto ref_info = frames_.find(frame.references[i]);
-            bool ref_continuous = ref_info != frames_.end() && ref_info->second.continuous;
+            auto ref_info = find(frame.references[i]);
+            bool ref_continuous = ref_info != nullptr && ref_info->continuous;
             not_yet_fulfilled_dependencies.push_back(
                 { frame.references[i], ref_continuous });
         }
     }
 
-    info->second.num_missing_continuous = not_yet_fulfilled_dependencies.size();
-    info->second.num_missing_decodable = not_yet_fulfilled_dependencies.size();
+    info.num_missing_continuous = not_yet_fulfilled_dependencies.size();
+    info.num_missing_decodable = not_yet_fulfilled_dependencies.size();
 
+    // insert() checked that the references fit the window along with the
+    // frame, so none of them can land on the slot of another live frame.
     for (const Dependency& dep : not_yet_fulfilled_dependencies) {
+        FrameInfo* dep_info = find_or_create(dep.frame_id);
+        if (dep_info == nullptr) {
+            return false;
+        }
         if (dep.continuous)
-            --info->second.num_missing_continuous;
+            --info.num_missing_continuous;
 
-        frames_[dep.frame_id].dependent_frames.push_back(frame.id);
+        dep_info->dependent_frames.push_back(frame.id);
     }
 
     return true;
 }
 
+void FrameBuffer::propagate_continuity(FrameInfo& start)
+{
+    continuous_frames_.clear();
+    continuous_frames_.push_back(&start);
+    while (!continuous_frames_.empty()) {
+        FrameInfo* info = continuous_frames_.back();
+        continuous_frames_.pop_back();
+        if (!last_continuous_frame_ || *last_continuous_frame_ < info->id) {
+            last_continuous_frame_ = info->id;
+        }
+        queue_if_decodable(*info);
+        // Loop through all dependent frames, and if that frame no longer has
+        // any unfulfilled dependencies then that frame is continuous as well.
+        for (int64_t dependent_id : info->dependent_frames) {
+            FrameInfo* dependent = find(dependent_id);
+            assert(dependent != nullptr);
+            if (dependent != nullptr && --dependent->num_missing_continuous == 0) {
+                dependent->continuous = true;
+                continuous_frames_.push_back(dependent);
+            }
+        }
+    }
+}
+
+void FrameBuffer::propagate_decodability(const FrameInfo& info)
+{
+    for (int64_t dependent_id : info.dependent_frames) {
+        FrameInfo* dependent = find(dependent_id);
+        assert(dependent != nullptr && dependent->num_missing_decodable > 0);
+        if (dependent != nullptr && --dependent->num_missing_decodable == 0) {
+            queue_if_decodable(*dependent);
+        }
+    }
+}
+
+void FrameBuffer::queue_if_decodable(const FrameInfo& info)
+{
+    // Both only ever change once, so a frame is queued exactly once.
+    if (info.continuous && info.num_missing_decodable == 0) {
+        decodable_frames_.push(info.id);
+    }
+}
+
+bool FrameBuffer::fits_window(const ReceivedFrame& frame)
+{
+    // The frame and every reference that still gets a slot, references up to
+    // the last decoded frame are looked up in the history instead.
+    auto last_decoded_frame = decoded_frames_history_.GetLastDecodedFrameId();
+    int64_t first_id = frame.id;
+    int64_t last_id = frame.id;
+    for (size_t i = 0; i < frame.num_references; ++i) {
+        if (!last_decoded_frame || frame.references[i] > *last_decoded_frame) {
+            first_id = std::min(first_id, frame.references[i]);
+            last_id = std::max(last_id, frame.references[i]);
+        }
+    }
+    if (num_frames_ > 0) {
+        first_id = std::min(first_id, first_frame_id_);
+        last_id = std::max(last_id, last_frame_id_);
+    }
+    return last_id - first_id < static_cast<int64_t>(frames_.size());
+}
+
+FrameBuffer::FrameInfo* FrameBuffer::find(int64_t frame_id)
+{
+    FrameInfo& info = frames_[frame_id & frames_mask_];
+    return info.id == frame_id ? &info : nullptr;
+}
+
+FrameBuffer::FrameInfo* FrameBuffer::find_or_create(int64_t frame_id)
+{
+    FrameInfo& info = frames_[frame_id & frames_mask_];
+    if (info.id == frame_id) {
+        return &info;
+    }
+    if (info.id != kNoFrame) {
+        // Held by another frame, taking it would corrupt the table.
+        return nullptr;
+    }
+    info.reset(frame_id);
+    if (num_frames_++ == 0) {
+        first_frame_id_ = frame_id;
+        last_frame_id_ = frame_id;
+    } else {
+        first_frame_id_ = std::min(first_frame_id_, frame_id);
+        last_frame_id_ = std::max(last_frame_id_, frame_id);
+    }
+    return &info;
+}
+
+void FrameBuffer::erase_frames_before(int64_t frame_id)
+{
+    for (int64_t id = first_frame_id_; id < frame_id && num_frames_ > 0; id++) {
+        if (FrameInfo* info = find(id)) {
+            info->reset(kNoFrame);
+            num_frames_--;
+        }
+    }
+    first_frame_id_ = std::max(first_frame_id_, frame_id);
+}
+
 } // namespace brtc
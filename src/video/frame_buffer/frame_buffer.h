@@ -1,6 +1,8 @@
 #pragma once
+#include <functional>
 #include <optional>
-#include <map>
+#include <queue>
+#include <vector>
 #include "rtp/rtp.h"
 #include "video/frame_buffer/decoded_frames_history.h"
 
@@ -12,6 +14,13 @@ class FrameBuffer {
         FrameInfo(FrameInfo&&) = default;
         ~FrameInfo() = default;
 
+        // Makes the slot hold |frame_id|, keeping the capacity of
+        // |dependent_frames| so a reused slot does not allocate.
+        void reset(int64_t frame_id);
+
+        // Id of the frame this slot belongs to, kNoFrame when the slot is free.
+        int64_t id = kNoFrame;
+
         // Which other frames that have direct unfulfilled dependencies
         // on this frame.
         std::vector<int64_t> dependent_frames;
@@ -34,25 +43,51 @@ class FrameBuffer {
         //std::unique_ptr<ReceivedFrame> frame;
         std::optional<ReceivedFrame> frame;
     };
-    using FrameMap = std::map<int64_t, FrameInfo>;
+    static constexpr int64_t kNoFrame = -1;
 
 public:
     FrameBuffer(size_t decoded_history_size);
     void insert(ReceivedFrame frame);
+    // Returns the oldest continuous frame whose references have all been
+    // decoded, frames older than it are dropped as they can no longer be used.
+    // There is no decode scheduling against render time, a frame is released
+    // as soon as it is decodable.
     std::optional<ReceivedFrame> pop_decodable_frame();
+    size_t size() const;
 
 private:
-    bool valid_references(ReceivedFrame frame);
+    bool valid_references(const ReceivedFrame& frame);
     void clear_frames_and_history();
-    bool update_frame_info_with_incoming_frame(const ReceivedFrame& frame,
-        FrameMap::iterator info);
+    bool update_frame_info_with_incoming_frame(const ReceivedFrame& frame, FrameInfo& info);
+    void propagate_continuity(FrameInfo& start);
+    void propagate_decodability(const FrameInfo& info);
+    // Queues |info| for pop_decodable_frame() once it is both continuous and
+    // decodable.
+    void queue_if_decodable(const FrameInfo& info);
+
+    // |frames_| is a ring indexed by frame id, every id between
+    // |first_frame_id_| and |last_frame_id_| maps to its own slot.
+    // Whether |frame|, its references and the frames already buffered span
+    // few enough ids to each get their own slot.
+    bool fits_window(const ReceivedFrame& frame);
+    FrameInfo* find(int64_t frame_id);
+    // Null if the slot of |frame_id| is held by another frame.
+    FrameInfo* find_or_create(int64_t frame_id);
+    void erase_frames_before(int64_t frame_id);
 
 private:
     std::optional<int64_t> last_continuous_frame_;
-    FrameMap frames_;
+    std::vector<FrameInfo> frames_;
+    size_t frames_mask_;
+    size_t num_frames_ = 0;
+    int64_t first_frame_id_ = 0;
+    int64_t last_frame_id_ = 0;
+    std::vector<FrameInfo*> continuous_frames_;
+    // Ids of frames ready to decode, oldest first. Entries of frames erased
+    // since are skipped when they come up.
+    std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>> decodable_frames_;
     webrtc::video_coding::DecodedFramesHistory decoded_frames_history_;
-    std::vector<FrameMap::iterator> frames_to_decode_;
-    int64_t last_log_non_decoded_ms_;
+    int64_t last_log_non_decoded_ms_ = 0;
 };
 
 } // namespace brtc
\ No newline at end of file
@@ -3,11 +3,11 @@
 
 namespace brtc {
 
-std::unique_ptr<Packetizer> Packetizer::create(Frame decoded_frame, VideoCodecType codec_type, PayloadSizeLimits limits)
+std::unique_ptr<Packetizer> Packetizer::create(Frame decoded_frame, VideoCodecType codec_type, PayloadSizeLimits limits, PayloadMode mode)
 {
     switch (codec_type) {
     case brtc::VideoCodecType::H264:
-        return std::make_unique<PacketizerH264>(decoded_frame, limits);
+        return std::make_unique<PacketizerH264>(decoded_frame, limits, mode);
     case brtc::VideoCodecType::H265:
         return nullptr;
     case brtc::VideoCodecType::VP8:
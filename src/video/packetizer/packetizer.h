@@ -2,7 +2,9 @@
 #pragma once
 #include <cstdint>
 #include <array>
+#include <memory>
 #include <queue>
+#include <span>
 #include <brtc/frame.h>
 #include "rtp/rtp.h"
 
@@ -19,12 +21,27 @@ public:
         int single_packet_reduction_len = 0;
     };
 
+    enum class PayloadMode {
+        // Payload bytes are written into the packet's own buffer.
+        kCopy,
+        // Fragments are appended as references to the frame memory, which the
+        // packets keep alive, so they are gathered from the encoder output
+        // when sent instead of being copied first.
+        kReference,
+    };
+
 public:
     virtual ~Packetizer() { }
-    static std::unique_ptr<Packetizer> create(Frame decoded_frame, VideoCodecType codec_type, PayloadSizeLimits limits);
+    static std::unique_ptr<Packetizer> create(Frame decoded_frame, VideoCodecType codec_type, PayloadSizeLimits limits, PayloadMode mode = PayloadMode::kCopy);
     bool is_valid_frame() const { return is_valid_frame_; }
     virtual bool next_packet(RtpPacket& packet) = 0;
     virtual bool has_next_packet() const = 0;
+    // Packets still to come, all of them right after create().
+    virtual size_t num_packets() const = 0;
+    // Writes the payloads and marker bits of the next packets into |packets|
+    // in one call, returns how many were written. Headers and extensions are
+    // left to the caller and have to be in place already.
+    virtual size_t next_packets(std::span<RtpPacket> packets) = 0;
 
 protected:
     bool is_valid_frame_ = false;
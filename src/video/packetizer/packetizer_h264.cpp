@@ -9,7 +9,10 @@
  */
 
 #include "video/packetizer/packetizer_h264.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include "common/annexb.h"
 
 namespace brtc {
 
@@ -48,46 +51,18 @@ enum NaluType : uint8_t {
 
 } // namespace
 
-static std::tuple<uint8_t*, int32_t> find_nalu(std::span<uint8_t> data)
-{
-    if (data.size() < kH264StartCodeLength) {
-        return { nullptr, -1 };
-    }
-    uint8_t* head = data.data();
-    uint8_t* end = data.data() + data.size() - kH264StartCodeLength;
-    while (head < end) {
-        if (head[0]) {
-            head++;
-            continue;
-        }
-        if (head[1]) {
-            head += 2;
-            continue;
-        }
-        if (head[2]) {
-            if (head[2] == 0x01) {
-                return { head, 3 };
-            }
-            head += 3;
-            continue;
-        }
-        if (head[3] != 0x01) {
-            head++;
-            continue;
-        }
-        return { head, 4 };
-    }
-    return { nullptr, -1 };
-}
-
-PacketizerH264::PacketizerH264(Frame encoded_frame, PayloadSizeLimits limits)
+PacketizerH264::PacketizerH264(Frame encoded_frame, PayloadSizeLimits limits, PayloadMode mode)
     : frame_(encoded_frame)
     , limits_(limits)
+    , mode_(mode)
 {
     if (!do_fragmentation()) {
         return;
     }
     do_packetization();
+    if (mode_ == PayloadMode::kReference) {
+        frame_owner_ = std::make_shared<std::any>(frame_._data_holder);
+    }
 }
 
 bool PacketizerH264::next_packet(RtpPacket& rtp_packet)
@@ -95,12 +70,32 @@ bool PacketizerH264::next_packet(RtpPacket& rtp_packet)
     if (packets_.empty()) {
         return false;
     }
+    write_next_packet(rtp_packet);
+    return true;
+}
+
+size_t PacketizerH264::next_packets(std::span<RtpPacket> packets)
+{
+    const size_t count = std::min(packets.size(), num_packets_left_);
+    for (size_t i = 0; i < count; i++) {
+        write_next_packet(packets[i]);
+    }
+    return count;
+}
+
+size_t PacketizerH264::num_packets() const
+{
+    return num_packets_left_;
+}
+
+void PacketizerH264::write_next_packet(RtpPacket& rtp_packet)
+{
     PacketUnit packet = packets_.front();
     if (packet.first_fragment && packet.last_fragment) {
         // Single NAL unit packet.
-        rtp_packet.set_payload(packet.source_fragment);
+        write_fragment(rtp_packet, packet.source_fragment, {});
         packets_.pop_front();
-        nalus_.pop_front();
+        current_nalu_++;
     } else if (packet.aggregated) {
         next_aggregate_packet(rtp_packet);
     } else {
@@ -108,7 +103,6 @@ bool PacketizerH264::next_packet(RtpPacket& rtp_packet)
     }
     rtp_packet.set_marker(packets_.empty());
     --num_packets_left_;
-    return true;
 }
 
 bool PacketizerH264::has_next_packet() const
@@ -118,52 +112,50 @@ bool PacketizerH264::has_next_packet() const
 
 bool PacketizerH264::do_fragmentation()
 {
-    int32_t index = 0;
-    uint8_t* nalus[kMaxNalusPerPacket + 1];
-    uint32_t start_code_lens[kMaxNalusPerPacket + 1];
-    std::span<uint8_t> remain_data { (uint8_t*)frame_.data, frame_.length };
-    while (index < kMaxNalusPerPacket) {
-        auto [nalu, start_code_len] = find_nalu(remain_data);
-        if (nalu == nullptr) {
+    // One pass over the frame, each start code closes the NALU before it.
+    const std::span<uint8_t> data { (uint8_t*)frame_.data, frame_.length };
+    size_t offset = 0;
+    while (offset < data.size()) {
+        const StartCode start_code = find_start_code(data.subspan(offset));
+        if (start_code.length == 0) {
             break;
         }
-        nalus[index] = nalu;
-        start_code_lens[index] = start_code_len;
-        index++;
-        size_t offset = nalu - remain_data.data() + start_code_len;
-        if (offset >= remain_data.size()) {
-            break;
+        Nalu nalu;
+        nalu.offset = static_cast<uint32_t>(offset + start_code.offset);
+        nalu.start_code_length = static_cast<uint32_t>(start_code.length);
+        nalu.payload_length = 0;
+        if (!nalus_.empty()) {
+            Nalu& previous = nalus_.back();
+            previous.payload_length = nalu.offset - previous.offset - previous.start_code_length;
+        }
+        if (!nalus_.empty() && nalus_.back().payload_length == 0) {
+            // Back to back start codes, nothing to send for the first one.
+            nalus_.back() = nalu;
+        } else {
+            nalus_.push_back(nalu);
+        }
+        offset = nalu.offset + nalu.start_code_length;
+    }
+    if (!nalus_.empty()) {
+        Nalu& last = nalus_.back();
+        last.payload_length = frame_.length - last.offset - last.start_code_length;
+        if (last.payload_length == 0) {
+            nalus_.pop_back();
         }
-        remain_data = remain_data.subspan(offset);
     }
-    if (index == 0) {
+    if (nalus_.empty()) {
         is_valid_frame_ = false;
         return false;
     }
-    nalus_len_ = index;
-    nalus_.resize(nalus_len_);
-    for (uint32_t i = 0; i < nalus_len_; i++) {
-        Nalu nalu;
-        nalu.offset = static_cast<uint32_t>(nalus[i] - static_cast<uint8_t*>(frame_.data));
-        nalu.start_code_length = start_code_lens[i];
-        if (i == nalus_len_ - 1) {
-            nalu.payload_length = frame_.length - nalu.offset - nalu.start_code_length;
-        }
-        if (i != 0) {
-            nalus_[i - 1].payload_length = nalu.offset - nalus_[i - 1].offset - nalus_[i - 1].start_code_length;
-        }
-        nalus_[i] = nalu;
-    }
     return true;
 }
 
 bool PacketizerH264::do_packetization()
 {
-    constexpr int kMaxPayloadLength = 1200;
     //����stapa �� fu����֧��single
     for (size_t i = 0; i < nalus_.size();) {
         int fragment_len = nalus_[i].payload_length;
-        int single_packet_capacity = kMaxPayloadLength;
+        int single_packet_capacity = limits_.max_payload_len;
         if (nalus_.size() == 1)
             single_packet_capacity -= limits_.single_packet_reduction_len;
         else if (i == 0)
@@ -386,14 +378,10 @@ void PacketizerH264::next_fragment_packet(RtpPacket& rtp_packet)
     fu_header |= (packet->last_fragment ? kEBit : 0);
     uint8_t type = packet->header & kTypeMask;
     fu_header |= type;
-    auto fragment = packet->source_fragment;
-    std::vector<uint8_t> buffer(kFuAHeaderSize + fragment.size());
-    buffer[0] = fu_indicator;
-    buffer[1] = fu_header;
-    memcpy(buffer.data() + kFuAHeaderSize, fragment.data(), fragment.size());
-    rtp_packet.set_payload(std::move(buffer));
+    const uint8_t fu_headers[kFuAHeaderSize] = { fu_indicator, fu_header };
+    write_fragment(rtp_packet, packet->source_fragment, fu_headers);
     if (packet->last_fragment)
-        nalus_.pop_front();
+        current_nalu_++;
     packets_.pop_front();
 }
 
@@ -418,12 +406,15 @@ void PacketizerH264::next_fragment_packet(RtpPacket& rtp_packet)
 */
 void PacketizerH264::next_aggregate_packet(RtpPacket& rtp_packet)
 {
-    // Reserve maximum available payload, set actual payload size later.
+    // Aggregates are small, parameter sets mostly, and are always written in
+    // place even in PayloadMode::kReference.
     size_t payload_len = kNalHeaderSize;
-    for (auto& packet : packets_) {
-        payload_len += kLengthFieldSize + kNalHeaderSize + packet.source_fragment.size();
+    for (const auto& packet : packets_) {
+        payload_len += kLengthFieldSize + packet.source_fragment.size();
+        if (packet.last_fragment)
+            break;
     }
-    std::vector<uint8_t> buffer(payload_len);
+    std::span<uint8_t> buffer = rtp_packet.allocate_payload(payload_len);
     PacketUnit* packet = &packets_.front();
     assert(packet->first_fragment == true);
     // STAP-A NALU header.
@@ -442,14 +433,31 @@ void PacketizerH264::next_aggregate_packet(RtpPacket& rtp_packet)
         memcpy(&buffer[index], fragment.data(), fragment.size());
         index += fragment.size();
         packets_.pop_front();
-        nalus_.pop_front();
+        current_nalu_++;
         if (is_last_fragment)
             break;
         packet = &packets_.front();
         is_last_fragment = packet->last_fragment;
     }
     assert(is_last_fragment);
-    rtp_packet.set_payload(std::span<uint8_t>(buffer.data(), index));
+    assert(index == payload_len);
+}
+
+void PacketizerH264::write_fragment(RtpPacket& rtp_packet, std::span<uint8_t> fragment, std::span<const uint8_t> header)
+{
+    if (mode_ == PayloadMode::kReference) {
+        if (!header.empty()) {
+            auto buffer = rtp_packet.allocate_payload(header.size());
+            memcpy(buffer.data(), header.data(), header.size());
+        }
+        rtp_packet.append_payload_reference(fragment, frame_owner_);
+        return;
+    }
+    auto buffer = rtp_packet.allocate_payload(header.size() + fragment.size());
+    if (!header.empty()) {
+        memcpy(buffer.data(), header.data(), header.size());
+    }
+    memcpy(buffer.data() + header.size(), fragment.data(), fragment.size());
 }
 
 } // namespace brtc
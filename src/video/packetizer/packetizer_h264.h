@@ -13,12 +13,14 @@
 #include <brtc/frame.h>
 #include <cstdint>
 #include <queue>
+#include "common/small_vector.h"
 #include "rtp/rtp.h"
 #include "video/packetizer/packetizer.h"
 
 namespace brtc {
 
-class PacketizerH264 : public Packetizer {
+class PacketizerH264 final : public Packetizer {
+    static constexpr size_t kInlineNalusPerFrame = 64;
 
     struct PacketUnit {
         PacketUnit(std::span<uint8_t> source_fragment,
@@ -42,32 +44,40 @@ class PacketizerH264 : public Packetizer {
     };
 
 public:
-    explicit PacketizerH264(Frame decoded_frame, PayloadSizeLimits limits);
+    PacketizerH264(Frame decoded_frame, PayloadSizeLimits limits, PayloadMode mode = PayloadMode::kCopy);
     bool next_packet(RtpPacket& packet) override;
     bool has_next_packet() const override;
+    size_t num_packets() const override;
+    size_t next_packets(std::span<RtpPacket> packets) override;
 
 private:
     bool do_fragmentation();
     bool do_packetization();
+    void write_next_packet(RtpPacket& rtp_packet);
     bool packetize_FuA(size_t index);
     size_t packetize_StapA(size_t index);
     std::vector<int> split_about_equally(int payload_len, const PayloadSizeLimits& limits);
     void next_fragment_packet(RtpPacket& rtp_packet);
     void next_aggregate_packet(RtpPacket& rtp_packet);
+    void write_fragment(RtpPacket& rtp_packet, std::span<uint8_t> fragment, std::span<const uint8_t> header);
 
 private:
+    // Index of the NALU the next packet starts in.
     uint32_t current_nalu_ = 0;
-    uint32_t nalus_len_ = 0;
     Frame frame_;
     struct Nalu {
         uint32_t start_code_length;
         uint32_t offset;
         uint32_t payload_length;
     };
-    //std::array<Nalu, kMaxNalusPerPacket> nalus_;
-    std::deque<Nalu> nalus_;
+    // Low latency encoders emit dozens of slices per frame, enough room for
+    // them inline, the packetizer itself lives on the heap anyway.
+    SmallVector<Nalu, kInlineNalusPerFrame> nalus_;
     std::deque<PacketUnit> packets_;
     PayloadSizeLimits limits_;
+    PayloadMode mode_;
+    // Keeps the frame memory alive for packets referencing it.
+    std::shared_ptr<const void> frame_owner_;
     size_t num_packets_left_ = 0;
 };
 
@@ -34,7 +34,8 @@ private:
 RtpFrameReferenceFinder::ReturnVector RtpFrameReferenceFinderImpl::ManageFrame(
     std::unique_ptr<ReceivedFrame> frame)
 {
-    const RTPVideoHeader& video_header = std::get<RTPVideoHeader>(frame->video_header);
+    // The common part of whichever codec header the frame carries.
+    const RTPVideoHeader& video_header = std::visit([](const auto& header) -> const RTPVideoHeader& { return header; }, frame->video_header);
 
     if (video_header.generic.has_value()) {
         return GetRefFinderAs<webrtc::RtpGenericFrameRefFinder>().ManageFrame(
@@ -82,7 +83,11 @@ RtpFrameReferenceFinder::ReturnVector RtpFrameReferenceFinderImpl::ManageFrame(
 RtpFrameReferenceFinder::ReturnVector
 RtpFrameReferenceFinderImpl::PaddingReceived(uint16_t seq_num)
 {
-    return std::get<webrtc::RtpSeqNumOnlyRefFinder>(ref_finder_).PaddingReceived(seq_num);
+    // Only frames without picture ids are referenced by sequence number.
+    if (auto ref_finder = std::get_if<webrtc::RtpSeqNumOnlyRefFinder>(&ref_finder_)) {
+        return ref_finder->PaddingReceived(seq_num);
+    }
+    return {};
 
 }
 
@@ -139,21 +144,25 @@ void RtpFrameReferenceFinder::ManageFrame(std::unique_ptr<ReceivedFrame> frame)
     if (cleared_to_seq_num_ != -1 && webrtc::AheadOf<uint16_t>(static_cast<uint16_t>(cleared_to_seq_num_), frame->first_seq_num)) {
         return;
     }
-    auto frames = impl_->ManageFrame(std::move(frame));
+    queue_frames(impl_->ManageFrame(std::move(frame)));
+}
+
+void RtpFrameReferenceFinder::PaddingReceived(uint16_t seq_num)
+{
+    queue_frames(impl_->PaddingReceived(seq_num));
+}
+
+void RtpFrameReferenceFinder::queue_frames(ReturnVector frames)
+{
     for (auto& f : frames) {
         f->id = f->id + picture_id_offset_;
         for (size_t i = 0; i < f->num_references; ++i) {
             f->references[i] += picture_id_offset_;
-            frames_.push(std::move(f));
         }
+        frames_.push(std::move(f));
     }
 }
 
-RtpFrameReferenceFinder::ReturnVector RtpFrameReferenceFinder::PaddingReceived(uint16_t seq_num)
-{
-    return impl_->PaddingReceived(seq_num);
-}
-
 void RtpFrameReferenceFinder::ClearTo(uint16_t seq_num)
 {
     cleared_to_seq_num_ = seq_num;
@@ -28,7 +28,7 @@ public:
 
     // Notifies that padding has been received, which the reference finder
     // might need to calculate the references of a frame.
-    ReturnVector PaddingReceived(uint16_t seq_num);
+    void PaddingReceived(uint16_t seq_num);
 
     // Clear all stashed frames that include packets older than |seq_num|.
     void ClearTo(uint16_t seq_num);
@@ -36,7 +36,9 @@ public:
     std::unique_ptr<ReceivedFrame> pop_gop_inter_continous_frame();
 
 private:
+    void queue_frames(ReturnVector frames);
 
+private:
     // How far frames have been cleared out of the buffer by RTP sequence number.
     // A frame will be cleared if it contains a packet with a sequence number
     // older than |cleared_to_seq_num_|.